@@ -0,0 +1,260 @@
+﻿#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <bytecode/bytecode.h>
+#include <parser/parser.h>
+
+namespace {
+	const char* usage =
+		"usage: bench [-n count] [-d depth] [-m mix] [-o order] [-r repeat] [-s seed]\n"
+		"\n"
+		"Generates a corpus of random functions and writes the throughput and latency of\n"
+		"tokenizing, parsing, differentiating, printing and evaluating them as JSON.\n"
+		"\n"
+		"  -n count   number of functions in the corpus (default 1000)\n"
+		"  -d depth   maximal depth of a function (default 8)\n"
+		"  -m mix     operators: arith, trig or all (default all)\n"
+		"  -o order   highest order of the repeated derivative (default 4)\n"
+		"  -r repeat  passes over the corpus for every benchmark (default 3)\n"
+		"  -s seed    seed of the generator (default 1)\n";
+
+	struct Options {
+		int count{ 1000 };
+		int depth{ 8 };
+		std::string mix{ "all" };
+		int order{ 4 };
+		int repeat{ 3 };
+		unsigned seed{ 1 };
+	};
+
+	bool Number(const char* text, int& value) {
+		char* end = nullptr;
+		long v = std::strtol(text, &end, 10);
+		value = static_cast<int>(v);
+		return end != text && *end == '\0' && v >= 0;
+	}
+
+	bool ParseOptions(int argc, char* argv[], Options& options) {
+		for (int i = 1; i < argc; ++i) {
+			std::string arg(argv[i]);
+			if (i + 1 >= argc) return false;
+			const char* value = argv[++i];
+			int number = 0;
+			if (arg == "-m") {
+				options.mix = value;
+				if (options.mix != "arith" && options.mix != "trig" && options.mix != "all") return false;
+				continue;
+			}
+			if (!Number(value, number)) return false;
+			if (arg == "-n" && number > 0) options.count = number;
+			else if (arg == "-d") options.depth = number;
+			else if (arg == "-o") options.order = number;
+			else if (arg == "-r" && number > 0) options.repeat = number;
+			else if (arg == "-s") options.seed = static_cast<unsigned>(number);
+			else return false;
+		}
+		return true;
+	}
+
+	// случайные функции заданной глубины; набор операций задается смесью
+	class Generator {
+	public:
+		explicit Generator(const Options& options) : random(options.seed), depth(options.depth) {
+			if (options.mix != "trig") binary = { " + ", " - ", " * ", " / ", " ^ " };
+			if (options.mix != "arith") unary = { "sin", "cos", "tg", "ctg", "ln", "lg", "sqrt" };
+			else unary = { "sqrt" };
+			if (binary.empty()) binary = { " + ", " * " };
+		}
+		std::string Next() {
+			std::string out;
+			Write(out, depth);
+			return out;
+		}
+	private:
+		// глубина ограничена параметром -d, поэтому рекурсия здесь допустима
+		void Write(std::string& out, int level) {
+			std::uniform_int_distribution<int> pick(0, 9);
+			int kind = level == 0 ? 0 : pick(random);
+			if (kind < 2) {
+				int leaf = pick(random);
+				if (leaf < 6) out += "x";
+				else if (leaf == 6) out += "e";
+				else if (leaf == 7) out += "pi";
+				else out += std::to_string(1 + pick(random));
+				return;
+			}
+			if (kind < 5) {
+				out += unary[std::uniform_int_distribution<size_t>(0, unary.size() - 1)(random)];
+				out += "(";
+				Write(out, level - 1);
+				out += ")";
+				return;
+			}
+			const char* op = binary[std::uniform_int_distribution<size_t>(0, binary.size() - 1)(random)];
+			out += "(";
+			Write(out, level - 1);
+			out += op;
+			// показатель степени - небольшое число, иначе значения уходят в бесконечность
+			if (op[1] == '^') out += std::to_string(2 + pick(random) % 3);
+			else Write(out, level - 1);
+			out += ")";
+		}
+		std::mt19937 random;
+		int depth;
+		std::vector<const char*> binary;
+		std::vector<const char*> unary;
+	};
+
+	using Clock = std::chrono::steady_clock;
+
+	double Nanoseconds(Clock::time_point start) {
+		return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+	}
+
+	// замеры одной операции: время каждого вызова и обработанные байты
+	struct Measure {
+		explicit Measure(std::string name) : name(std::move(name)) {}
+		std::string name;
+		std::vector<double> latencies;
+		double bytes{ 0.0 };
+		// дополнительные поля JSON: имя и значение
+		std::vector<std::pair<std::string, double>> extra;
+	};
+
+	double Percentile(const std::vector<double>& sorted, double p) {
+		if (sorted.empty()) return 0.0;
+		size_t i = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+		return sorted[i];
+	}
+
+	void WriteJson(const Options& options, size_t corpus_bytes, const std::vector<Measure>& measures) {
+		std::printf("{\n  \"corpus\": {\"count\": %d, \"depth\": %d, \"mix\": \"%s\", \"seed\": %u, \"repeat\": %d, \"bytes\": %zu},\n",
+			options.count, options.depth, options.mix.c_str(), options.seed, options.repeat, corpus_bytes);
+		std::printf("  \"benchmarks\": [\n");
+		for (size_t i = 0; i < measures.size(); ++i) {
+			const Measure& m = measures[i];
+			std::vector<double> sorted(m.latencies);
+			std::sort(sorted.begin(), sorted.end());
+			double total = 0.0;
+			for (double t : sorted) total += t;
+			double seconds = total * 1e-9;
+			std::printf("    {\"name\": \"%s\", \"items\": %zu, \"total_ns\": %.0f, \"items_per_s\": %.1f",
+				m.name.c_str(), sorted.size(), total, seconds > 0 ? static_cast<double>(sorted.size()) / seconds : 0.0);
+			if (m.bytes > 0) std::printf(", \"bytes_per_s\": %.1f", seconds > 0 ? m.bytes / seconds : 0.0);
+			std::printf(", \"latency_ns\": {\"p50\": %.0f, \"p90\": %.0f, \"p99\": %.0f, \"max\": %.0f}",
+				Percentile(sorted, 0.5), Percentile(sorted, 0.9), Percentile(sorted, 0.99), sorted.empty() ? 0.0 : sorted.back());
+			for (const auto& [key, value] : m.extra) std::printf(", \"%s\": %.0f", key.c_str(), value);
+			std::printf("}%s\n", i + 1 < measures.size() ? "," : "");
+		}
+		std::printf("  ]\n}\n");
+	}
+
+	// точки вычисления: внутри области определения большинства функций корпуса
+	std::vector<double> Points() {
+		std::vector<double> xs(256);
+		for (size_t i = 0; i < xs.size(); ++i) xs[i] = 0.5 + 2.0 * static_cast<double>(i) / static_cast<double>(xs.size());
+		return xs;
+	}
+}
+
+int main(int argc, char* argv[]) {
+	Options options;
+	if (!ParseOptions(argc, argv, options)) {
+		std::cerr << usage;
+		return 2;
+	}
+	Generator generator(options);
+	std::vector<std::string> corpus;
+	size_t corpus_bytes = 0;
+	for (int i = 0; i < options.count; ++i) {
+		corpus.push_back(generator.Next());
+		corpus_bytes += corpus.back().size();
+	}
+	std::vector<double> xs = Points();
+	std::vector<double> values(xs.size());
+	// результат вычислений копится здесь, чтобы компилятор их не выбросил
+	volatile double sink = 0.0;
+
+	Measure tokenize("tokenize"), parse("parse"), der("der"), repr("repr"), eval("eval"), batch("eval_batch");
+	std::vector<Measure> orders;
+	for (int n = 1; n <= options.order; ++n) orders.emplace_back("der_" + std::to_string(n));
+	std::vector<double> nodes(options.order + 1, 0.0), repr_bytes(options.order + 1, 0.0);
+	simpleparser::Tokenizer tokenizer;
+	for (int pass = 0; pass < options.repeat; ++pass) {
+		for (const std::string& text : corpus) {
+			Clock::time_point start = Clock::now();
+			std::vector<simpleparser::Token> tokens = tokenizer.Tokenize(text);
+			tokenize.latencies.push_back(Nanoseconds(start));
+			tokenize.bytes += static_cast<double>(text.size());
+			sink = sink + static_cast<double>(tokens.size());
+
+			// каждая функция в своем хранилище: иначе Der() возвращал бы запомненную производную
+			FuncStore store;
+			FuncStore::Scope scope(store);
+			start = Clock::now();
+			Func* f = simpleparser::Parser(text).Parse();
+			parse.latencies.push_back(Nanoseconds(start));
+			parse.bytes += static_cast<double>(text.size());
+
+			start = Clock::now();
+			Func* d = f->Der();
+			der.latencies.push_back(Nanoseconds(start));
+
+			start = Clock::now();
+			std::string printed = d->repr();
+			repr.latencies.push_back(Nanoseconds(start));
+			repr.bytes += static_cast<double>(printed.size());
+
+			start = Clock::now();
+			for (double x : xs) sink = sink + d->Eval(x);
+			eval.latencies.push_back(Nanoseconds(start));
+
+			bytecode::Program program(d);
+			start = Clock::now();
+			program.EvalBatch(xs.data(), values.data(), xs.size());
+			batch.latencies.push_back(Nanoseconds(start));
+			sink = sink + values[0];
+		}
+	}
+	// производные высших порядков без упрощения: узлы растут линейно, длина записи - экспоненциально
+	for (int pass = 0; pass < options.repeat; ++pass) {
+		for (const std::string& text : corpus) {
+			FuncStore store;
+			FuncStore::Scope scope(store);
+			Func* f = simpleparser::Parser(text).Parse();
+			for (int n = 1; n <= options.order; ++n) {
+				Clock::time_point start = Clock::now();
+				f = f->Der();
+				orders[n - 1].latencies.push_back(Nanoseconds(start));
+				if (pass == 0) nodes[n] += static_cast<double>(store.Size());
+			}
+		}
+	}
+	for (int n = 1; n <= options.order; ++n) {
+		orders[n - 1].extra.push_back({ "nodes", nodes[n] });
+		// длина записи растет экспоненциально с порядком, поэтому печатаются только первые порядки
+		if (n <= 4) {
+			for (const std::string& text : corpus) {
+				FuncStore store;
+				FuncStore::Scope scope(store);
+				Func* f = simpleparser::Parser(text).Parse();
+				for (int k = 0; k < n; ++k) f = f->Der();
+				repr_bytes[n] += static_cast<double>(f->repr().size());
+			}
+			orders[n - 1].extra.push_back({ "repr_bytes", repr_bytes[n] });
+		}
+	}
+	eval.extra.push_back({ "points", static_cast<double>(xs.size()) });
+	batch.extra.push_back({ "points", static_cast<double>(xs.size()) });
+	std::vector<Measure> measures{ tokenize, parse, der, repr, eval, batch };
+	measures.insert(measures.end(), orders.begin(), orders.end());
+	WriteJson(options, corpus_bytes, measures);
+	return 0;
+}
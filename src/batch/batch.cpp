@@ -0,0 +1,44 @@
+﻿#include <batch/batch.h>
+
+#include <sstream>
+
+#include <parser/parser.h>
+
+namespace batch {
+	namespace {
+		Result Process(const std::string& input, const Options& options) {
+			// хранилище живет вместе с потоком, а очистка оставляет ему блок арены
+			thread_local FuncStore store;
+			store.Clear();
+			FuncStore::Scope scope(store);
+			Result result;
+			simpleparser::ParseResult parsed = simpleparser::Parser(input).TryParse();
+			if (!parsed) {
+				result.error = parsed.error;
+				result.offset = parsed.offset;
+				return result;
+			}
+			Func* var = options.variable == "x" ? Make<X>() : Make<Var>(options.variable);
+			Func* f = options.simplify ? Simplify(parsed.func) : parsed.func;
+			for (int i = 0; i < options.order; ++i) {
+				f = f->Der(var);
+				if (options.simplify) f = Simplify(f);
+			}
+			std::ostringstream os;
+			os << *f;
+			result.derivative = os.str();
+			return result;
+		}
+	}
+
+	std::vector<Result> Differentiate(const std::vector<std::string>& inputs, const Options& options,
+		ThreadPool& pool) {
+		std::vector<Result> results(inputs.size());
+		pool.For(inputs.size(), [&](size_t i) { results[i] = Process(inputs[i], options); });
+		return results;
+	}
+
+	std::vector<Result> Differentiate(const std::vector<std::string>& inputs, const Options& options) {
+		return Differentiate(inputs, options, ThreadPool::Default());
+	}
+}
@@ -0,0 +1,60 @@
+﻿#ifndef BATCH_BATCH_H_20261018
+#define BATCH_BATCH_H_20261018
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <batch/pool.h>
+
+namespace batch {
+
+	/// Параметры пакетного дифференцирования
+	struct Options {
+		/// Порядок производной, 0 - сама функция
+		int order{ 1 };
+		/// Переменная дифференцирования
+		std::string variable{ "x" };
+		/// Упрощать функцию и каждую производную
+		bool simplify{ false };
+	};
+
+	/// Результат обработки одной строки
+	struct Result {
+		/// Запись производной; пустая при ошибке
+		std::string derivative;
+		/// Сообщение об ошибке разбора; пустое при успехе
+		std::string error;
+		/// Позиция ошибки во входной строке
+		size_t offset{ 0 };
+		/// Строка разобрана
+		explicit operator bool() const noexcept { return error.empty(); }
+	};
+
+	/*!
+	\brief Функция находит производные функций, заданных строками, параллельно
+
+	Строки распределяются по потокам пула с перехватом задач. Каждый поток разбирает
+	и дифференцирует строку в своем хранилище FuncStore, которое очищается перед
+	следующей строкой, поэтому потоки не делят изменяемых данных, а память не растет
+	с числом строк. Результаты возвращаются в порядке входных строк.
+
+	Пример
+	\code
+	std::vector<batch::Result> results = batch::Differentiate({ "sin(x)", "x ^ 2", "(" });
+	std::cout << results[0].derivative << '\n'; // cos(x)
+	std::cout << results[2].error << '\n';
+	\endcode
+	\param[in] inputs записи функций
+	\param[in] options параметры
+	\param[in] pool пул потоков
+	\return std::vector<Result> результаты, по одному на строку
+	*/
+	std::vector<Result> Differentiate(const std::vector<std::string>& inputs, const Options& options,
+		ThreadPool& pool);
+
+	/// Differentiate() в пуле ThreadPool::Default()
+	std::vector<Result> Differentiate(const std::vector<std::string>& inputs, const Options& options = {});
+}
+
+#endif // !BATCH_BATCH_H_20261018
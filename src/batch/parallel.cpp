@@ -0,0 +1,33 @@
+﻿#include <batch/parallel.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace batch {
+	namespace {
+		// блок точек EvalBatch() и работа (инструкции на точки), меньше которой потоки не нужны
+		constexpr size_t kBlock = 256;
+		constexpr size_t kWork = size_t(1) << 18;
+	}
+
+	void EvalBatch(const bytecode::Program& program, const double* xs, double* out, size_t n, ThreadPool& pool) {
+		// каждый вызов EvalBatch() заново заполняет регистры констант, поэтому отрезков 
+		// немногим больше, чем потоков
+		size_t blocks = (n + kBlock - 1) / kBlock, chunks = std::min(blocks, 8 * (pool.Size() + 1));
+		if (chunks < 2 || program.Size() * n < kWork) {
+			program.EvalBatch(xs, out, n);
+			return;
+		}
+		size_t grain = (blocks + chunks - 1) / chunks * kBlock, outputs = program.Outputs();
+		chunks = (n + grain - 1) / grain;
+		pool.For(chunks, [&](size_t c) {
+			size_t start = c * grain, m = std::min(grain, n - start);
+			// EvalBatch() пишет функцию k отрезка подряд, а в out ее значения идут с шагом n
+			thread_local std::vector<double> buffer;
+			if (buffer.size() < outputs * m) buffer.resize(outputs * m);
+			program.EvalBatch(xs + start, buffer.data(), m);
+			for (size_t k = 0; k < outputs; ++k)
+				std::copy_n(buffer.data() + k * m, m, out + k * n + start);
+		});
+	}
+}
@@ -0,0 +1,34 @@
+﻿#ifndef BATCH_PARALLEL_H_20261018
+#define BATCH_PARALLEL_H_20261018
+
+#include <cstddef>
+
+#include <batch/pool.h>
+#include <bytecode/bytecode.h>
+
+namespace batch {
+
+	/*!
+	\brief Функция вычисляет программу в массиве точек на всех потоках пула
+
+	Для одной большой функции почти все время уходит на вычисление: производная и 
+	упрощение линейны по размеру, а каждая точка проходит всю программу. Точки делятся 
+	на отрезки из целых блоков EvalBatch(), по нескольку отрезков на поток; работа 
+	меньше примерно 2^18 инструкций на точку выполняется в текущем потоке. 
+	Значения те же, что у program.EvalBatch()
+
+	Пример
+	\code
+	bytecode::Program program(Simplify(simpleparser::Parser(huge).Parse()->Der()));
+	batch::EvalBatch(program, xs.data(), values.data(), xs.size(), batch::ThreadPool::Default());
+	\endcode
+	\param[in] program программа
+	\param[in] xs массив из n значений первой переменной
+	\param[out] out массив из Outputs() * n значений: функция k в точке i лежит в out[k * n + i]
+	\param[in] n количество точек
+	\param[in] pool пул потоков
+	*/
+	void EvalBatch(const bytecode::Program& program, const double* xs, double* out, size_t n, ThreadPool& pool);
+}
+
+#endif // !BATCH_PARALLEL_H_20261018
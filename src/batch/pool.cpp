@@ -0,0 +1,139 @@
+﻿#include <batch/pool.h>
+
+#include <algorithm>
+
+namespace batch {
+	namespace {
+		// пул и номер очереди текущего потока, если он поток пула
+		thread_local ThreadPool* current_pool{ nullptr };
+		thread_local size_t current_index{ 0 };
+	}
+
+	ThreadPool::ThreadPool(size_t count) {
+		if (count == 0) {
+			size_t cores = std::thread::hardware_concurrency();
+			count = cores > 1 ? cores - 1 : 1;
+		}
+		for (size_t i = 0; i < count; ++i) queues.push_back(std::make_unique<Queue>());
+		for (size_t i = 0; i < count; ++i) threads.emplace_back(&ThreadPool::Loop, this, i);
+	}
+
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(sleep);
+			stop = true;
+		}
+		wake.notify_all();
+		for (std::thread& thread : threads) thread.join();
+	}
+
+	ThreadPool& ThreadPool::Default() {
+		static ThreadPool pool;
+		return pool;
+	}
+
+	void ThreadPool::Submit(Task task) {
+		size_t index = current_pool == this ? current_index : next.fetch_add(1, std::memory_order_relaxed) % queues.size();
+		{
+			std::lock_guard<std::mutex> lock(queues[index]->mutex);
+			queues[index]->tasks.push_back(std::move(task));
+		}
+		pending.fetch_add(1);
+		// пустой захват мьютекса не дает потоку пропустить пробуждение между проверкой и ожиданием
+		{
+			std::lock_guard<std::mutex> lock(sleep);
+		}
+		wake.notify_one();
+	}
+
+	bool ThreadPool::Take(size_t self, Task& task) {
+		if (pending.load() == 0) return false;
+		{
+			Queue& own = *queues[self];
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if (!own.tasks.empty()) {
+				task = std::move(own.tasks.back());
+				own.tasks.pop_back();
+				pending.fetch_sub(1);
+				return true;
+			}
+		}
+		for (size_t k = 1; k < queues.size(); ++k) {
+			Queue& victim = *queues[(self + k) % queues.size()];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (!victim.tasks.empty()) {
+				task = std::move(victim.tasks.front());
+				victim.tasks.pop_front();
+				pending.fetch_sub(1);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool ThreadPool::RunOne() {
+		size_t self = current_pool == this ? current_index : next.load(std::memory_order_relaxed) % queues.size();
+		Task task;
+		if (!Take(self, task)) return false;
+		task();
+		return true;
+	}
+
+	void ThreadPool::Loop(size_t index) {
+		current_pool = this;
+		current_index = index;
+		for (;;) {
+			Task task;
+			if (Take(index, task)) {
+				task();
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(sleep);
+			wake.wait(lock, [this] { return stop || pending.load() > 0; });
+			if (stop && pending.load() == 0) return;
+		}
+	}
+
+	void ThreadPool::For(size_t n, const std::function<void(size_t)>& body) {
+		size_t chunk = std::max<size_t>(1, n / (16 * (Size() + 1)));
+		TaskGroup group(*this);
+		for (size_t begin = 0; begin < n; begin += chunk) {
+			size_t end = std::min(n, begin + chunk);
+			group.Run([&body, begin, end] {
+				for (size_t i = begin; i < end; ++i) body(i);
+			});
+		}
+		group.Wait();
+	}
+
+	TaskGroup::~TaskGroup() {
+		// исключение уже нельзя передать, но задачи не должны пережить группу
+		while (active.load() > 0)
+			if (!pool.RunOne()) std::this_thread::yield();
+	}
+
+	void TaskGroup::Run(std::function<void()> task) {
+		active.fetch_add(1);
+		pool.Submit([this, task = std::move(task)] {
+			try {
+				task();
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!error) error = std::current_exception();
+			}
+			active.fetch_sub(1);
+		});
+	}
+
+	void TaskGroup::Wait() {
+		while (active.load() > 0)
+			if (!pool.RunOne()) std::this_thread::yield();
+		std::exception_ptr rethrown;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			std::swap(rethrown, error);
+		}
+		if (rethrown) std::rethrow_exception(rethrown);
+	}
+}
@@ -0,0 +1,117 @@
+﻿#ifndef BATCH_POOL_H_20261018
+#define BATCH_POOL_H_20261018
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Пространство имен, содержащее параллельную обработку функций
+namespace batch {
+
+	/*!
+	\brief Пул потоков с перехватом задач (work stealing)
+
+	У каждого потока своя очередь: новые задачи потока кладутся в ее конец и оттуда
+	же берутся (последние задачи еще в кэше), а простаивающий поток забирает самую
+	старую задачу из начала чужой очереди. Задачи, отправленные из потоков вне пула,
+	раскладываются по очередям по кругу. Поток, ожидающий TaskGroup, сам выполняет
+	задачи пула, поэтому вложенные группы не блокируют пул.
+
+	Пример
+	\code
+	batch::ThreadPool pool;
+	std::vector<double> out(n);
+	pool.For(n, [&](size_t i) { out[i] = Work(i); });
+	\endcode
+	*/
+	class ThreadPool {
+	public:
+		/*!
+		\brief Конструктор, запускающий потоки
+		\param[in] threads количество потоков; 0 - на один меньше числа ядер,
+		так как ожидающий поток тоже выполняет задачи
+		*/
+		explicit ThreadPool(size_t threads = 0);
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		/// Деструктор, дожидающийся всех отправленных задач
+		~ThreadPool();
+		/// Количество потоков пула
+		size_t Size() const noexcept { return threads.size(); }
+		/*!
+		\brief Метод отправляет задачу в пул
+		\param[in] task задача
+		*/
+		void Submit(std::function<void()> task);
+		/*!
+		\brief Метод выполняет в текущем потоке одну задачу пула: свою или перехваченную
+		\return bool false, если задач нет
+		*/
+		bool RunOne();
+		/*!
+		\brief Метод выполняет body(i) для всех i из [0, n) и дожидается завершения
+
+		Индексы делятся на отрезки, заметно более мелкие, чем n / Size(), чтобы
+		неравные по времени задачи выравнивались перехватом
+		\param[in] n количество индексов
+		\param[in] body функция, которую можно вызывать из нескольких потоков сразу
+		*/
+		void For(size_t n, const std::function<void(size_t)>& body);
+		/// Пул по умолчанию, общий для процесса
+		static ThreadPool& Default();
+	private:
+		using Task = std::function<void()>;
+		struct Queue {
+			std::mutex mutex;
+			std::deque<Task> tasks;
+		};
+		bool Take(size_t self, Task& task);
+		void Loop(size_t index);
+		std::vector<std::unique_ptr<Queue>> queues;
+		std::vector<std::thread> threads;
+		std::mutex sleep;
+		std::condition_variable wake;
+		std::atomic<size_t> pending{ 0 };
+		std::atomic<size_t> next{ 0 };
+		bool stop{ false };
+	};
+
+	/*!
+	\brief Группа задач пула, завершения которых можно дождаться
+
+	Первое исключение, выброшенное задачей группы, передается из Wait()
+	*/
+	class TaskGroup {
+	public:
+		/// Конструктор группы задач пула pool
+		explicit TaskGroup(ThreadPool& pool) : pool(pool) {}
+		TaskGroup(const TaskGroup&) = delete;
+		TaskGroup& operator=(const TaskGroup&) = delete;
+		/// Деструктор, дожидающийся задач группы
+		~TaskGroup();
+		/*!
+		\brief Метод отправляет задачу группы в пул
+		\param[in] task задача
+		*/
+		void Run(std::function<void()> task);
+		/*!
+		\brief Метод дожидается задач группы, выполняя задачи пула
+		\throw исключение первой задачи группы, завершившейся им
+		*/
+		void Wait();
+	private:
+		ThreadPool& pool;
+		std::atomic<size_t> active{ 0 };
+		std::mutex mutex;
+		std::exception_ptr error;
+	};
+}
+
+#endif // !BATCH_POOL_H_20261018
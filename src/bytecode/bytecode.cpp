@@ -0,0 +1,257 @@
+﻿#include <bytecode/bytecode.h>
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace bytecode {
+	namespace {
+		OpCode Operation(FuncType type) {
+			switch (type) {
+			case FuncType::SUM: return OpCode::ADD;
+			case FuncType::SUB: return OpCode::SUB;
+			case FuncType::MULT: return OpCode::MULT;
+			case FuncType::DIVISION: return OpCode::DIVISION;
+			case FuncType::POW: return OpCode::POWER;
+			case FuncType::SIN: return OpCode::SIN;
+			case FuncType::COS: return OpCode::COS;
+			case FuncType::TG: return OpCode::TG;
+			case FuncType::CTG: return OpCode::CTG;
+			case FuncType::LN: return OpCode::LN;
+			case FuncType::LG: return OpCode::LG;
+			default: return OpCode::SQRT;
+			}
+		}
+
+		bool IsVariable(const Func* f) {
+			return f->type == FuncType::X || f->type == FuncType::VAR;
+		}
+
+		bool IsLeaf(const Func* f) {
+			return f->type == FuncType::NUM || f->type == FuncType::E || f->type == FuncType::PI || IsVariable(f);
+		}
+
+		// ширина блока точек в EvalBatch, кратна ширине любого вектора
+		constexpr size_t block = 256;
+
+		template <class F>
+		void Map(const double* a, const double* b, double* dst, size_t n, F f) {
+			for (size_t i = 0; i < n; ++i) dst[i] = f(a[i], b[i]);
+		}
+
+		const KernelTable* ScalarKernels() {
+			static const KernelTable table{ {
+				[](const double* a, const double* b, double* d, size_t n) { Map(a, b, d, n, [](double u, double v) { return u + v; }); },
+				[](const double* a, const double* b, double* d, size_t n) { Map(a, b, d, n, [](double u, double v) { return u - v; }); },
+				[](const double* a, const double* b, double* d, size_t n) { Map(a, b, d, n, [](double u, double v) { return u * v; }); },
+				[](const double* a, const double* b, double* d, size_t n) { Map(a, b, d, n, [](double u, double v) { return u / v; }); },
+				[](const double* a, const double* b, double* d, size_t n) { Map(a, b, d, n, [](double u, double v) { return std::pow(u, v); }); },
+				[](const double* a, const double* b, double* d, size_t n) { Map(a, b, d, n, [](double u, double) { return std::sqrt(u); }); },
+				[](const double* a, const double* b, double* d, size_t n) { Map(a, b, d, n, [](double u, double) { return std::sin(u); }); },
+				[](const double* a, const double* b, double* d, size_t n) { Map(a, b, d, n, [](double u, double) { return std::cos(u); }); },
+				[](const double* a, const double* b, double* d, size_t n) { Map(a, b, d, n, [](double u, double) { return std::tan(u); }); },
+				[](const double* a, const double* b, double* d, size_t n) { Map(a, b, d, n, [](double u, double) { return std::cos(u) / std::sin(u); }); },
+				[](const double* a, const double* b, double* d, size_t n) { Map(a, b, d, n, [](double u, double) { return std::log(u); }); },
+				[](const double* a, const double* b, double* d, size_t n) { Map(a, b, d, n, [](double u, double) { return std::log10(u); }); }
+			} };
+			return &table;
+		}
+
+		bool Supports(Isa isa) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+			if (isa == Isa::AVX2) return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+			if (isa == Isa::AVX512) return __builtin_cpu_supports("avx512f");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+			int info[4];
+			__cpuid(info, 1);
+			bool osxsave = info[2] & (1 << 27), fma = info[2] & (1 << 12);
+			if (!osxsave) return isa == Isa::SCALAR;
+			unsigned long long xcr0 = _xgetbv(0);
+			__cpuidex(info, 7, 0);
+			if (isa == Isa::AVX2) return fma && (info[1] & (1 << 5)) && (xcr0 & 0x6) == 0x6;
+			if (isa == Isa::AVX512) return (info[1] & (1 << 16)) && (xcr0 & 0xe6) == 0xe6;
+#endif
+			return isa == Isa::SCALAR;
+		}
+
+		const KernelTable* Kernels(Isa isa) {
+			if (isa == Isa::AVX512 && Avx512Kernels() && Supports(Isa::AVX512)) return Avx512Kernels();
+			if (isa != Isa::SCALAR && Avx2Kernels() && Supports(Isa::AVX2)) return Avx2Kernels();
+			return ScalarKernels();
+		}
+	}
+
+	Isa BestIsa() {
+		static const Isa best = Kernels(Isa::AVX512) == Avx512Kernels() ? Isa::AVX512 :
+			Kernels(Isa::AVX2) == Avx2Kernels() ? Isa::AVX2 : Isa::SCALAR;
+		return best;
+	}
+
+	Program::Program(Func* f) {
+		Compile({ f }, { Make<X>() });
+	}
+
+	Program::Program(const std::vector<Func*>& roots) {
+		Compile(roots, { Make<X>() });
+	}
+
+	Program::Program(const std::vector<Func*>& roots, const std::vector<Func*>& vars) {
+		Compile(roots, vars);
+	}
+
+	void Program::Compile(const std::vector<Func*>& roots, const std::vector<Func*>& vars) {
+		// обратный порядок обхода без рекурсии, каждая функция один раз
+		std::vector<Func*> order;
+		std::unordered_map<Func*, std::uint32_t> uses;
+		std::vector<std::pair<Func*, bool>> stack;
+		for (Func* root : roots) {
+			++uses[root];
+			stack.push_back({ root, false });
+		}
+		std::unordered_map<Func*, bool> visited;
+		while (!stack.empty()) {
+			auto [f, expanded] = stack.back();
+			stack.pop_back();
+			if (expanded) {
+				order.push_back(f);
+				continue;
+			}
+			if (visited[f]) continue;
+			visited[f] = true;
+			stack.push_back({ f, true });
+			for (int i = f->Arity() - 1; i >= 0; --i) {
+				Func* arg = f->Arg(i);
+				++uses[arg];
+				if (!visited[arg]) stack.push_back({ arg, false });
+			}
+		}
+		// листья: переменные в первых регистрах, константы из пула следом
+		std::unordered_map<Func*, std::uint32_t> reg;
+		std::unordered_map<double, std::uint32_t> pool;
+		inputs = vars.size();
+		for (size_t i = 0; i < vars.size(); ++i) reg.emplace(vars[i], static_cast<std::uint32_t>(i));
+		for (Func* f : order) {
+			if (!IsLeaf(f) || reg.count(f)) continue;
+			// переменная сравнивается по имени: f и vars могут быть из разных хранилищ
+			if (IsVariable(f)) {
+				auto var = std::find_if(vars.begin(), vars.end(), [f](const Func* v) { return SameVariable(f, v); });
+				if (var != vars.end()) {
+					reg[f] = static_cast<std::uint32_t>(var - vars.begin());
+					continue;
+				}
+			}
+			// переменная не из vars - NaN, как в Func::Eval()
+			double value = IsVariable(f) ? std::nan("") : f->Eval(0.0);
+			auto found = pool.find(value);
+			if (found == pool.end()) {
+				found = pool.emplace(value, static_cast<std::uint32_t>(inputs + constants.size())).first;
+				constants.push_back(value);
+			}
+			reg[f] = found->second;
+		}
+		std::uint32_t fixed = static_cast<std::uint32_t>(inputs + constants.size());
+		std::uint32_t next = fixed;
+		std::vector<std::uint32_t> free;
+		auto release = [&](Func* f) {
+			if (--uses[f] == 0 && reg[f] >= fixed) free.push_back(reg[f]);
+		};
+		for (Func* f : order) {
+			if (IsLeaf(f)) continue;
+			Instruction instruction{ Operation(f->type), 0, reg[f->Arg(0)], 0 };
+			if (f->Arity() == 2) instruction.b = reg[f->Arg(1)];
+			// x ^ 2 вычисляется умножением
+			if (f->type == FuncType::POW && f->Arg(1)->type == FuncType::NUM && f->Arg(1)->Eval(0.0) == 2.0) {
+				instruction.op = OpCode::MULT;
+				instruction.b = instruction.a;
+			}
+			for (int i = 0; i < f->Arity(); ++i) release(f->Arg(i));
+			if (free.empty()) instruction.dst = next++;
+			else {
+				instruction.dst = free.back();
+				free.pop_back();
+			}
+			reg[f] = instruction.dst;
+			code.push_back(instruction);
+		}
+		for (Func* root : roots) outputs.push_back(reg[root]);
+		registers = next;
+	}
+
+	void Program::Run(const double* point, double* r) const {
+		std::copy_n(point, inputs, r);
+		std::copy(constants.begin(), constants.end(), r + inputs);
+		for (const Instruction& in : code) {
+			double a = r[in.a], b = r[in.b];
+			switch (in.op) {
+			case OpCode::ADD: r[in.dst] = a + b; break;
+			case OpCode::SUB: r[in.dst] = a - b; break;
+			case OpCode::MULT: r[in.dst] = a * b; break;
+			case OpCode::DIVISION: r[in.dst] = a / b; break;
+			case OpCode::POWER: r[in.dst] = std::pow(a, b); break;
+			case OpCode::SQRT: r[in.dst] = std::sqrt(a); break;
+			case OpCode::SIN: r[in.dst] = std::sin(a); break;
+			case OpCode::COS: r[in.dst] = std::cos(a); break;
+			case OpCode::TG: r[in.dst] = std::tan(a); break;
+			case OpCode::CTG: r[in.dst] = std::cos(a) / std::sin(a); break;
+			case OpCode::LN: r[in.dst] = std::log(a); break;
+			case OpCode::LG: r[in.dst] = std::log10(a); break;
+			}
+		}
+	}
+
+	const double* Program::Point(double x) const {
+		thread_local std::vector<double> point;
+		point.assign(std::max<size_t>(inputs, 1), std::nan(""));
+		point[0] = x;
+		return point.data();
+	}
+
+	double Program::Eval(double x) const {
+		thread_local std::vector<double> r;
+		if (r.size() < registers) r.resize(registers);
+		Run(Point(x), r.data());
+		return r[outputs.empty() ? 0 : outputs.front()];
+	}
+
+	void Program::Eval(double x, double* out) const {
+		Eval(Point(x), out);
+	}
+
+	void Program::Eval(const double* point, double* out) const {
+		thread_local std::vector<double> r;
+		if (r.size() < registers) r.resize(registers);
+		Run(point, r.data());
+		for (size_t i = 0; i < outputs.size(); ++i) out[i] = r[outputs[i]];
+	}
+
+	void Program::EvalBatch(const double* xs, double* out, size_t n) const {
+		EvalBatch(xs, out, n, BestIsa());
+	}
+
+	void Program::EvalBatch(const double* xs, double* out, size_t n, Isa isa) const {
+		const KernelTable* kernels = Kernels(isa);
+		thread_local std::vector<double> r;
+		if (r.size() < registers * block) r.resize(registers * block);
+		for (size_t i = 1; i < inputs; ++i)
+			std::fill_n(r.data() + i * block, block, std::nan(""));
+		for (size_t i = 0; i < constants.size(); ++i)
+			std::fill_n(r.data() + (inputs + i) * block, block, constants[i]);
+		for (size_t start = 0; start < n; start += block) {
+			size_t m = std::min(block, n - start);
+			// хвост блока дополняется последней точкой, чтобы не вычислять лишние особые значения
+			if (inputs > 0) {
+				std::copy_n(xs + start, m, r.data());
+				std::fill(r.data() + m, r.data() + block, xs[start + m - 1]);
+			}
+			for (const Instruction& in : code)
+				kernels->run[static_cast<int>(in.op)](r.data() + in.a * block, r.data() + in.b * block, r.data() + in.dst * block, block);
+			for (size_t k = 0; k < outputs.size(); ++k)
+				std::copy_n(r.data() + outputs[k] * block, m, out + k * n + start);
+		}
+	}
+}
@@ -0,0 +1,173 @@
+﻿#ifndef BYTECODE_BYTECODE_H_20261018
+#define BYTECODE_BYTECODE_H_20261018
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <bytecode/kernels.h>
+#include <functions/functions.h>
+
+/// Пространство имен, содержащее компилятор функций в линейный байткод
+namespace bytecode {
+
+	/// Перечисление, содержащее все операции байткода
+	enum class OpCode : std::uint8_t {
+		ADD,
+		SUB,
+		MULT,
+		DIVISION,
+		POWER,
+		SQRT,
+		SIN,
+		COS,
+		TG,
+		CTG,
+		LN,
+		LG
+	};
+
+	/// Инструкция: регистр dst = op(регистр a, регистр b)
+	struct Instruction {
+		OpCode op;
+		std::uint32_t dst;
+		std::uint32_t a;
+		std::uint32_t b;
+	};
+
+	/*!
+	\brief Функция определяет лучший набор инструкций, поддерживаемый процессором
+	\return Isa
+	*/
+	Isa BestIsa();
+
+	/*!
+	\brief Класс, содержащий функцию, скомпилированную в линейную последовательность инструкций
+
+	Функции обходятся в обратном порядке (сначала аргументы), каждая различная
+	подфункция вычисляется один раз, одинаковые числа хранятся в пуле констант.
+	Регистры переиспользуются, как только значение больше не нужно, поэтому их
+	число обычно много меньше числа функций. Первые регистры содержат переменные 
+	(по умолчанию одну x), следом идут константы.
+
+	Пример создания и использования
+	\code
+	simpleparser::Parser parser("x * sin(x) ^ 2");
+	Func* f = parser.Parse();
+	bytecode::Program program({ f, f->Der() });
+	double out[2];
+	for (double x = 0; x < 1; x += 1e-6) {
+		program.Eval(x, out); // out[0] = f(x), out[1] = f'(x)
+	}
+	std::vector<double> xs(1000000), values(2 * xs.size());
+	program.EvalBatch(xs.data(), values.data(), xs.size());
+	\endcode
+	*/
+	class Program {
+	public:
+		/// Конструктор по умолчанию
+		Program() = default;
+		/// Конструктор копирования
+		Program(const Program&) = default;
+		/// Конструктор перемещающего копирования
+		Program(Program&&) = default;
+		/// Оператор копирующего присваивания
+		Program& operator=(const Program&) = default;
+		/// Оператор перемещающего присваивания
+		Program& operator=(Program&&) = default;
+		/// Деструктор
+		~Program() = default;
+		/*!
+		\brief Конструктор, компилирующий одну функцию
+		\param[in] f функция
+		*/
+		explicit Program(Func* f);
+		/*!
+		\brief Конструктор, компилирующий несколько функций в одну программу
+
+		Общие подфункции всех функций вычисляются один раз
+		\param[in] roots функции, например f и f'
+		*/
+		explicit Program(const std::vector<Func*>& roots);
+		/*!
+		\brief Конструктор, компилирующий функции нескольких переменных
+
+		Переменные, не вошедшие в vars, равны NaN
+		\code
+		Func* f = simpleparser::Parser("x * y + sin(x * z)").Parse();
+		std::vector<Func*> vars = Variables(f);
+		std::vector<Func*> roots = Gradient(f, vars);
+		roots.insert(roots.begin(), f);
+		bytecode::Program program(roots, vars);
+		double point[] = { 1, 2, 3 }, out[4];
+		program.Eval(point, out); // f, df/dx, df/dy, df/dz
+		\endcode
+		\param[in] roots функции
+		\param[in] vars переменные (X или Var) в порядке значений точки
+		*/
+		Program(const std::vector<Func*>& roots, const std::vector<Func*>& vars);
+		/*!
+		\brief Метод вычисляет первую функцию программы
+		\param[in] x значение первой переменной, остальные равны NaN
+		\return double
+		*/
+		double Eval(double x) const;
+		/*!
+		\brief Метод вычисляет все функции программы
+		\param[in] x значение первой переменной, остальные равны NaN
+		\param[out] out массив из Outputs() значений
+		*/
+		void Eval(double x, double* out) const;
+		/*!
+		\brief Метод вычисляет все функции программы нескольких переменных
+		\param[in] point массив из Inputs() значений переменных
+		\param[out] out массив из Outputs() значений
+		*/
+		void Eval(const double* point, double* out) const;
+		/*!
+		\brief Метод вычисляет все функции программы в массиве точек
+
+		Точки обрабатываются блоками, каждая инструкция выполняется над целым блоком 
+		векторным ядром лучшего набора инструкций, доступного процессору (см. BestIsa()). 
+		Трансцендентные функции вычисляются полиномиальными приближениями с погрешностью 
+		в несколько ulp (у x ^ y она растет с |y ln x|); вне области приближения 
+		используется стандартная библиотека.
+		\param[in] xs массив из n значений первой переменной, остальные равны NaN
+		\param[out] out массив из Outputs() * n значений: функция k в точке i лежит в out[k * n + i]
+		\param[in] n количество точек
+		*/
+		void EvalBatch(const double* xs, double* out, size_t n) const;
+		/*!
+		\brief Метод вычисляет все функции программы в массиве точек заданным набором инструкций
+
+		Если набор не поддерживается процессором, используется лучший из доступных более простых
+		\param[in] isa набор инструкций
+		*/
+		void EvalBatch(const double* xs, double* out, size_t n, Isa isa) const;
+		/// Количество переменных
+		size_t Inputs() const noexcept { return inputs; }
+		/// Количество вычисляемых функций
+		size_t Outputs() const noexcept { return outputs.size(); }
+		/// Количество инструкций
+		size_t Size() const noexcept { return code.size(); }
+		/// Количество регистров
+		size_t Registers() const noexcept { return registers; }
+		/// Инструкции программы
+		const std::vector<Instruction>& Code() const noexcept { return code; }
+		/// Пул констант; константа i лежит в регистре Inputs() + i
+		const std::vector<double>& Constants() const noexcept { return constants; }
+		/// Регистры, в которых остаются значения функций
+		const std::vector<std::uint32_t>& Results() const noexcept { return outputs; }
+	private:
+		void Compile(const std::vector<Func*>& roots, const std::vector<Func*>& vars);
+		void Run(const double* point, double* r) const;
+		const double* Point(double x) const;
+		std::vector<Instruction> code;
+		std::vector<double> constants;
+		std::vector<std::uint32_t> outputs;
+		size_t inputs{ 1 };
+		size_t registers{ 1 };
+	};
+}
+
+#endif // !BYTECODE_BYTECODE_H_20261018
@@ -0,0 +1,33 @@
+﻿#ifndef BYTECODE_KERNELS_H_20261018
+#define BYTECODE_KERNELS_H_20261018
+
+#include <cstddef>
+
+namespace bytecode {
+
+	/// Набор инструкций, которым вычисляются пакеты значений
+	enum class Isa {
+		SCALAR,
+		AVX2,
+		AVX512
+	};
+
+	/*!
+	\brief Ядро операции над массивами: dst[i] = op(a[i], b[i])
+
+	n кратно ширине вектора; dst может совпадать с a или b
+	*/
+	using Kernel = void (*)(const double* a, const double* b, double* dst, size_t n);
+
+	/// Таблица ядер, индексируемая значением OpCode
+	struct KernelTable {
+		Kernel run[12];
+	};
+
+	/// Таблица ядер AVX2 + FMA либо nullptr, если они не собраны
+	const KernelTable* Avx2Kernels();
+	/// Таблица ядер AVX-512 либо nullptr, если они не собраны
+	const KernelTable* Avx512Kernels();
+}
+
+#endif // !BYTECODE_KERNELS_H_20261018
@@ -0,0 +1,68 @@
+﻿#include <bytecode/kernels.h>
+
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+
+#include <immintrin.h>
+
+namespace bytecode {
+	namespace {
+		struct Avx2 {
+			using V = __m256d;
+			using M = __m256d;
+			static constexpr int N = 4;
+
+			static V Set(double x) { return _mm256_set1_pd(x); }
+			static V Load(const double* p) { return _mm256_loadu_pd(p); }
+			static void Store(double* p, V x) { _mm256_storeu_pd(p, x); }
+			static V Add(V a, V b) { return _mm256_add_pd(a, b); }
+			static V Sub(V a, V b) { return _mm256_sub_pd(a, b); }
+			static V Mul(V a, V b) { return _mm256_mul_pd(a, b); }
+			static V Div(V a, V b) { return _mm256_div_pd(a, b); }
+			static V Fma(V a, V b, V c) { return _mm256_fmadd_pd(a, b, c); }
+			static V Sqrt(V a) { return _mm256_sqrt_pd(a); }
+			static V Floor(V a) { return _mm256_floor_pd(a); }
+			static V Abs(V a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+			static V Neg(V a) { return _mm256_xor_pd(_mm256_set1_pd(-0.0), a); }
+			static M Less(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+			static M LessEqual(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+			static M And(M a, M b) { return _mm256_and_pd(a, b); }
+			static M Xor(M a, M b) { return _mm256_xor_pd(a, b); }
+			static V Select(M m, V a, V b) { return _mm256_blendv_pd(b, a, m); }
+			static int Bits(M m) { return _mm256_movemask_pd(m); }
+			// x = m * 2^e, m из [0.5, 1); x нормальное
+			static V Frexp(V x, V& e) {
+				__m256i bits = _mm256_castpd_si256(x);
+				__m256i exponent = _mm256_srli_epi64(bits, 52);
+				// целое k < 2^52 переводится в double как (2^52 + k) - 2^52
+				V magic = _mm256_set1_pd(4503599627370496.0);
+				e = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(exponent, _mm256_castpd_si256(magic))), magic);
+				e = _mm256_sub_pd(e, _mm256_set1_pd(1022.0));
+				__m256i mantissa = _mm256_and_si256(bits, _mm256_set1_epi64x(0x800fffffffffffffll));
+				return _mm256_castsi256_pd(_mm256_or_si256(mantissa, _mm256_set1_epi64x(0x3fe0000000000000ll)));
+			}
+			// 2^n для целого n из [-1022, 1023]
+			static V Pow2(V n) {
+				V biased = _mm256_add_pd(n, _mm256_set1_pd(4503599627370496.0 + 1023.0));
+				return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_castpd_si256(biased), 52));
+			}
+		};
+	}
+}
+
+#include <bytecode/kernels_impl.h>
+
+namespace bytecode {
+	const KernelTable* Avx2Kernels() {
+		return VectorKernels<Avx2>::Table();
+	}
+}
+
+#else
+
+namespace bytecode {
+	const KernelTable* Avx2Kernels() {
+		return nullptr;
+	}
+}
+
+#endif
@@ -0,0 +1,72 @@
+﻿#include <bytecode/kernels.h>
+
+#if defined(__AVX512F__)
+
+#include <immintrin.h>
+
+namespace bytecode {
+	namespace {
+		struct Avx512 {
+			using V = __m512d;
+			using M = __mmask8;
+			static constexpr int N = 8;
+
+			static V Set(double x) { return _mm512_set1_pd(x); }
+			static V Load(const double* p) { return _mm512_loadu_pd(p); }
+			static void Store(double* p, V x) { _mm512_storeu_pd(p, x); }
+			static V Add(V a, V b) { return _mm512_add_pd(a, b); }
+			static V Sub(V a, V b) { return _mm512_sub_pd(a, b); }
+			static V Mul(V a, V b) { return _mm512_mul_pd(a, b); }
+			static V Div(V a, V b) { return _mm512_div_pd(a, b); }
+			static V Fma(V a, V b, V c) { return _mm512_fmadd_pd(a, b, c); }
+			// здесь и в сдвигах варианты с маской: без маски GCC 12 подставляет _mm512_undefined_*() и
+			// ложно предупреждает -Wmaybe-uninitialized
+			static V Sqrt(V a) { return _mm512_mask_sqrt_pd(a, 0xff, a); }
+			static V Floor(V a) { return _mm512_mask_roundscale_pd(a, 0xff, a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+			static V Abs(V a) { return _mm512_abs_pd(a); }
+			static V Neg(V a) {
+				return _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(a), _mm512_set1_epi64(0x8000000000000000ll)));
+			}
+			static M Less(V a, V b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+			static M LessEqual(V a, V b) { return _mm512_cmp_pd_mask(a, b, _CMP_LE_OQ); }
+			static M And(M a, M b) { return static_cast<M>(a & b); }
+			static M Xor(M a, M b) { return static_cast<M>(a ^ b); }
+			static V Select(M m, V a, V b) { return _mm512_mask_blend_pd(m, b, a); }
+			static int Bits(M m) { return m; }
+			// x = m * 2^e, m из [0.5, 1); x нормальное
+			static V Frexp(V x, V& e) {
+				__m512i bits = _mm512_castpd_si512(x);
+				__m512i exponent = _mm512_mask_srli_epi64(bits, 0xff, bits, 52);
+				// целое k < 2^52 переводится в double как (2^52 + k) - 2^52
+				V magic = _mm512_set1_pd(4503599627370496.0);
+				e = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(exponent, _mm512_castpd_si512(magic))), magic);
+				e = _mm512_sub_pd(e, _mm512_set1_pd(1022.0));
+				__m512i mantissa = _mm512_and_si512(bits, _mm512_set1_epi64(0x800fffffffffffffll));
+				return _mm512_castsi512_pd(_mm512_or_si512(mantissa, _mm512_set1_epi64(0x3fe0000000000000ll)));
+			}
+			// 2^n для целого n из [-1022, 1023]
+			static V Pow2(V n) {
+				V biased = _mm512_add_pd(n, _mm512_set1_pd(4503599627370496.0 + 1023.0));
+				return _mm512_castsi512_pd(_mm512_mask_slli_epi64(_mm512_castpd_si512(biased), 0xff, _mm512_castpd_si512(biased), 52));
+			}
+		};
+	}
+}
+
+#include <bytecode/kernels_impl.h>
+
+namespace bytecode {
+	const KernelTable* Avx512Kernels() {
+		return VectorKernels<Avx512>::Table();
+	}
+}
+
+#else
+
+namespace bytecode {
+	const KernelTable* Avx512Kernels() {
+		return nullptr;
+	}
+}
+
+#endif
@@ -0,0 +1,222 @@
+﻿#ifndef BYTECODE_KERNELS_IMPL_H_20261018
+#define BYTECODE_KERNELS_IMPL_H_20261018
+
+// Общая реализация векторных ядер. Подключается только из kernels_*.cpp, каждый
+// из которых собирается со своими флагами процессора и определяет класс S:
+// тип вектора V, тип маски M, ширину N и элементарные операции над ними.
+// Все определения имеют внутреннее связывание, поэтому версии не смешиваются.
+
+#include <cfloat>
+#include <cmath>
+
+#include <bytecode/kernels.h>
+
+namespace bytecode {
+	namespace {
+		template <class S>
+		struct VectorMath {
+			using V = typename S::V;
+			using M = typename S::M;
+
+			static V Poly(V x, const double* c, int n) {
+				V r = S::Set(c[0]);
+				for (int i = 1; i < n; ++i) r = S::Fma(r, x, S::Set(c[i]));
+				return r;
+			}
+
+			// натуральный логарифм нормального положительного числа (Cephes log) в виде
+			// суммы hi + lo, где lo - ошибка округления hi; нужна для точного x ^ y
+			static V Log(V x, V& lo) {
+				static const double p[] = {
+					1.01875663804580931796E-4, 4.97494994976747001425E-1, 4.70579119878881725854E0,
+					1.44989225341610930846E1, 1.79368678507819816313E1, 7.70838733755885391666E0
+				};
+				static const double q[] = {
+					1.0, 1.12873587189167450590E1, 4.52279145837532221105E1,
+					8.29875266912776603211E1, 7.11544750618563894466E1, 2.31251620126765340583E1
+				};
+				V e;
+				V m = S::Frexp(x, e);
+				M small = S::Less(m, S::Set(0.70710678118654752440));
+				V one = S::Set(1.0);
+				e = S::Select(small, S::Sub(e, one), e);
+				m = S::Select(small, S::Sub(S::Add(m, m), one), S::Sub(m, one));
+				V z = S::Mul(m, m);
+				V y = S::Mul(m, S::Div(S::Mul(z, Poly(m, p, 6)), Poly(m, q, 6)));
+				y = S::Fma(e, S::Set(-2.121944400546905827679e-4), y);
+				y = S::Fma(S::Set(-0.5), z, y);
+				// e * ln2_hi точно, сумма с m и y собирается с учетом ошибок округления
+				V a = S::Mul(e, S::Set(0.693359375));
+				V s1 = S::Add(a, m);
+				V t = S::Sub(s1, a);
+				V err = S::Add(S::Sub(a, S::Sub(s1, t)), S::Sub(m, t));
+				V hi = S::Add(s1, y);
+				lo = S::Add(S::Add(S::Sub(s1, hi), y), err);
+				return hi;
+			}
+
+			static V Log(V x) {
+				V lo;
+				V hi = Log(x, lo);
+				return S::Add(hi, lo);
+			}
+
+			// экспонента при |x| <= 708 (Cephes exp)
+			static V Exp(V x) {
+				static const double p[] = {
+					1.26177193074810590878E-4, 3.02994407707441961300E-2, 9.99999999999999999910E-1
+				};
+				static const double q[] = {
+					3.00198505138664455042E-6, 2.52448340349684104192E-3,
+					2.27265548208155028766E-1, 2.00000000000000000009E0
+				};
+				V n = S::Floor(S::Fma(S::Set(1.4426950408889634073599), x, S::Set(0.5)));
+				x = S::Fma(n, S::Set(-6.93145751953125E-1), x);
+				x = S::Fma(n, S::Set(-1.42860682030941723212E-6), x);
+				V xx = S::Mul(x, x);
+				V px = S::Mul(x, Poly(xx, p, 3));
+				x = S::Div(px, S::Sub(Poly(xx, q, 4), px));
+				x = S::Fma(S::Set(2.0), x, S::Set(1.0));
+				return S::Mul(x, S::Pow2(n));
+			}
+
+			// синус и косинус при |x| <= 1e8 (Cephes sin, cos)
+			static void SinCos(V x, V& s, V& c) {
+				static const double sincof[] = {
+					1.58962301576546568060E-10, -2.50507477628578072866E-8, 2.75573136213857245213E-6,
+					-1.98412698295895385996E-4, 8.33333333332211858878E-3, -1.66666666666666307295E-1
+				};
+				static const double coscof[] = {
+					-1.13585365213876817300E-11, 2.08757008419747316778E-9, -2.75573141792967388112E-7,
+					2.48015872888517045348E-5, -1.38888888888730564116E-3, 4.16666666666665929218E-2
+				};
+				V zero = S::Set(0.0);
+				M negative = S::Less(x, zero);
+				V y = S::Abs(x);
+				V j = S::Floor(S::Mul(y, S::Set(1.27323954473516268615)));
+				// нечетный номер октанта округляется вверх
+				V odd = S::Sub(j, S::Mul(S::Set(2.0), S::Floor(S::Mul(j, S::Set(0.5)))));
+				j = S::Add(j, odd);
+				V z = S::Fma(j, S::Set(-7.85398125648498535156E-1), y);
+				z = S::Fma(j, S::Set(-3.77489470793079817668E-8), z);
+				z = S::Fma(j, S::Set(-2.69515142907905952645E-15), z);
+				V octant = S::Sub(j, S::Mul(S::Set(8.0), S::Floor(S::Mul(j, S::Set(0.125)))));
+				M upper = S::Less(S::Set(3.5), octant);
+				octant = S::Select(upper, S::Sub(octant, S::Set(4.0)), octant);
+				M swap = S::Less(S::Abs(S::Sub(octant, S::Set(1.5))), S::Set(1.0));
+				V zz = S::Mul(z, z);
+				V ps = S::Fma(S::Mul(z, zz), Poly(zz, sincof, 6), z);
+				V pc = S::Fma(S::Mul(zz, zz), Poly(zz, coscof, 6), S::Fma(S::Set(-0.5), zz, S::Set(1.0)));
+				s = S::Select(swap, pc, ps);
+				c = S::Select(swap, ps, pc);
+				s = S::Select(S::Xor(upper, negative), S::Neg(s), s);
+				c = S::Select(S::Xor(upper, S::Less(S::Set(1.5), octant)), S::Neg(c), c);
+			}
+		};
+
+		template <class S>
+		struct VectorKernels {
+			using V = typename S::V;
+			using M = typename S::M;
+			using Math = VectorMath<S>;
+			static constexpr int full = (1 << S::N) - 1;
+
+			// пересчитывает стандартной библиотекой элементы, не попавшие в маску ok;
+			// аргументы передаются значениями, так как dst может совпадать с a или b
+			template <class F>
+			static void Fix(int ok, V x, V y, double* dst, F f) {
+				if (ok == full) return;
+				double a[S::N], b[S::N];
+				S::Store(a, x);
+				S::Store(b, y);
+				for (int i = 0; i < S::N; ++i)
+					if (!(ok >> i & 1)) dst[i] = f(a[i], b[i]);
+			}
+
+			static M Normal(V x) {
+				return S::And(S::LessEqual(S::Set(DBL_MIN), x), S::LessEqual(x, S::Set(DBL_MAX)));
+			}
+
+			static void Add(const double* a, const double* b, double* dst, size_t n) {
+				for (size_t i = 0; i < n; i += S::N) S::Store(dst + i, S::Add(S::Load(a + i), S::Load(b + i)));
+			}
+			static void Sub(const double* a, const double* b, double* dst, size_t n) {
+				for (size_t i = 0; i < n; i += S::N) S::Store(dst + i, S::Sub(S::Load(a + i), S::Load(b + i)));
+			}
+			static void Mult(const double* a, const double* b, double* dst, size_t n) {
+				for (size_t i = 0; i < n; i += S::N) S::Store(dst + i, S::Mul(S::Load(a + i), S::Load(b + i)));
+			}
+			static void Division(const double* a, const double* b, double* dst, size_t n) {
+				for (size_t i = 0; i < n; i += S::N) S::Store(dst + i, S::Div(S::Load(a + i), S::Load(b + i)));
+			}
+			static void Sqrt(const double* a, const double* b, double* dst, size_t n) {
+				for (size_t i = 0; i < n; i += S::N) S::Store(dst + i, S::Sqrt(S::Load(a + i)));
+			}
+			static void Power(const double* a, const double* b, double* dst, size_t n) {
+				for (size_t i = 0; i < n; i += S::N) {
+					V x = S::Load(a + i), y = S::Load(b + i);
+					M ok = Normal(x);
+					V lo;
+					V hi = Math::Log(S::Select(ok, x, S::Set(1.0)), lo);
+					// y * ln(x) = t + tail с почти удвоенной точностью
+					V t = S::Mul(y, hi);
+					V tail = S::Fma(y, lo, S::Fma(y, hi, S::Neg(t)));
+					ok = S::And(ok, S::LessEqual(S::Abs(t), S::Set(708.0)));
+					V r = Math::Exp(S::Select(ok, t, S::Set(0.0)));
+					S::Store(dst + i, S::Fma(r, S::Select(ok, tail, S::Set(0.0)), r));
+					Fix(S::Bits(ok), x, y, dst + i, [](double u, double v) { return std::pow(u, v); });
+				}
+			}
+			static void Ln(const double* a, const double* b, double* dst, size_t n) {
+				for (size_t i = 0; i < n; i += S::N) {
+					V x = S::Load(a + i), y = S::Load(b + i);
+					M ok = Normal(x);
+					S::Store(dst + i, Math::Log(S::Select(ok, x, S::Set(1.0))));
+					Fix(S::Bits(ok), x, y, dst + i, [](double u, double) { return std::log(u); });
+				}
+			}
+			static void Lg(const double* a, const double* b, double* dst, size_t n) {
+				for (size_t i = 0; i < n; i += S::N) {
+					V x = S::Load(a + i), y = S::Load(b + i);
+					M ok = Normal(x);
+					S::Store(dst + i, S::Mul(Math::Log(S::Select(ok, x, S::Set(1.0))), S::Set(0.43429448190325182765)));
+					Fix(S::Bits(ok), x, y, dst + i, [](double u, double) { return std::log10(u); });
+				}
+			}
+			template <class F, class G>
+			static void Trig(const double* a, const double* b, double* dst, size_t n, F combine, G scalar) {
+				for (size_t i = 0; i < n; i += S::N) {
+					V x = S::Load(a + i), s, c;
+					// знак нуля теряется при приведении, а ctg(-0) = -inf, поэтому нули 
+					// тоже пересчитываются стандартной библиотекой
+					M ok = S::And(S::Less(S::Set(0.0), S::Abs(x)), S::LessEqual(S::Abs(x), S::Set(1e8)));
+					Math::SinCos(S::Select(ok, x, S::Set(0.0)), s, c);
+					S::Store(dst + i, combine(s, c));
+					Fix(S::Bits(ok), x, x, dst + i, scalar);
+				}
+			}
+			static void Sin(const double* a, const double* b, double* dst, size_t n) {
+				Trig(a, b, dst, n, [](V s, V) { return s; }, [](double u, double) { return std::sin(u); });
+			}
+			static void Cos(const double* a, const double* b, double* dst, size_t n) {
+				Trig(a, b, dst, n, [](V, V c) { return c; }, [](double u, double) { return std::cos(u); });
+			}
+			static void Tg(const double* a, const double* b, double* dst, size_t n) {
+				Trig(a, b, dst, n, [](V s, V c) { return S::Div(s, c); }, [](double u, double) { return std::tan(u); });
+			}
+			static void Ctg(const double* a, const double* b, double* dst, size_t n) {
+				Trig(a, b, dst, n, [](V s, V c) { return S::Div(c, s); }, [](double u, double) { return std::cos(u) / std::sin(u); });
+			}
+
+			static const KernelTable* Table() {
+				// порядок совпадает с OpCode
+				static const KernelTable table{ {
+					Add, Sub, Mult, Division, Power, Sqrt, Sin, Cos, Tg, Ctg, Ln, Lg
+				} };
+				return &table;
+			}
+		};
+	}
+}
+
+#endif // !BYTECODE_KERNELS_IMPL_H_20261018
@@ -0,0 +1,192 @@
+﻿#include <cache/cache.h>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace cache {
+	namespace {
+		// версия ключа: меняется вместе со способом вычисления производной или записи
+		constexpr std::uint64_t kVersion = 1;
+
+		std::uint64_t Mix(std::uint64_t h, std::uint64_t v) {
+			// splitmix64 от суммы: детерминирован и не зависит от платформы
+			std::uint64_t z = h + 0x9e3779b97f4a7c15ull + v;
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+			return z ^ (z >> 31);
+		}
+
+		std::uint64_t Bytes(std::uint64_t h, std::string_view text) {
+			for (unsigned char c : text) h = Mix(h, c);
+			return Mix(h, text.size());
+		}
+
+		// обе половины ключа одного узла
+		Key Node(const Func* f, const Key* a, const Key* b) {
+			std::uint64_t value = static_cast<std::uint64_t>(f->type);
+			if (f->type == FuncType::NUM) {
+				float number = static_cast<const Num*>(f)->Value();
+				std::uint32_t bits;
+				std::memcpy(&bits, &number, sizeof(bits));
+				value = Mix(value, bits);
+			}
+			Key key{ Mix(0x6a09e667f3bcc908ull, value), Mix(0xbb67ae8584caa73bull, value) };
+			if (f->type == FuncType::VAR) {
+				const std::string& name = static_cast<const Var*>(f)->Name();
+				key = { Bytes(key.lo, name), Bytes(key.hi, name) };
+			}
+			for (const Key* arg : { a, b })
+				if (arg) key = { Mix(key.lo, arg->lo), Mix(key.hi, arg->hi) };
+			return key;
+		}
+	}
+
+	std::string Key::Hex() const {
+		char text[33];
+		std::snprintf(text, sizeof(text), "%016llx%016llx", static_cast<unsigned long long>(hi), static_cast<unsigned long long>(lo));
+		return text;
+	}
+
+	Key MakeKey(Func* f, const Options& options) {
+		std::unordered_map<const Func*, Key> keys;
+		std::vector<std::pair<const Func*, bool>> stack{ { f, false } };
+		while (!stack.empty()) {
+			auto [g, expanded] = stack.back();
+			if (keys.count(g)) {
+				stack.pop_back();
+				continue;
+			}
+			if (!expanded) {
+				stack.back().second = true;
+				for (int i = g->Arity() - 1; i >= 0; --i)
+					if (!keys.count(g->Arg(i))) stack.push_back({ g->Arg(i), false });
+				continue;
+			}
+			stack.pop_back();
+			const Key* a = g->Arity() > 0 ? &keys.at(g->Arg(0)) : nullptr;
+			const Key* b = g->Arity() > 1 ? &keys.at(g->Arg(1)) : nullptr;
+			keys.emplace(g, Node(g, a, b));
+		}
+		Key key = keys.at(f);
+		std::uint64_t parameters = Mix(Mix(kVersion, static_cast<std::uint64_t>(options.order)), options.simplify);
+		parameters = Bytes(parameters, options.variable);
+		return { Mix(key.lo, parameters), Mix(key.hi, ~parameters) };
+	}
+
+	DerivativeCache::DerivativeCache(size_t budget, std::string directory) : budget(budget), directory(std::move(directory)) {
+		if (!this->directory.empty()) {
+			std::error_code error;
+			std::filesystem::create_directories(this->directory, error);
+		}
+	}
+
+	size_t DerivativeCache::Cost(const Text& text) noexcept {
+		// запись, узел списка и узел таблицы
+		return text->size() + sizeof(std::string) + sizeof(Entry) + 64;
+	}
+
+	std::string DerivativeCache::Path(const Key& key) const {
+		return (std::filesystem::path(directory) / (key.Hex() + ".der")).string();
+	}
+
+	void DerivativeCache::Remember(const Key& key, Text text) {
+		auto found = entries.find(key);
+		if (found != entries.end()) {
+			order.splice(order.begin(), order, found->second);
+			return;
+		}
+		size_t cost = Cost(text);
+		if (cost > budget) return;
+		order.emplace_front(key, std::move(text));
+		entries.emplace(key, order.begin());
+		stats.bytes += cost;
+		while (stats.bytes > budget) {
+			stats.bytes -= Cost(order.back().second);
+			entries.erase(order.back().first);
+			order.pop_back();
+			++stats.evictions;
+		}
+		stats.entries = entries.size();
+	}
+
+	DerivativeCache::Text DerivativeCache::Find(const Key& key) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			auto found = entries.find(key);
+			if (found != entries.end()) {
+				order.splice(order.begin(), order, found->second);
+				++stats.hits;
+				return found->second->second;
+			}
+		}
+		if (directory.empty()) return nullptr;
+		std::ifstream file(Path(key), std::ios::binary);
+		if (!file) return nullptr;
+		auto text = std::make_shared<const std::string>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		std::lock_guard<std::mutex> lock(mutex);
+		++stats.disk_hits;
+		Remember(key, text);
+		return text;
+	}
+
+	void DerivativeCache::Insert(const Key& key, Text text) {
+		if (!directory.empty()) {
+			// запись во временный файл и переименование: другой процесс не прочитает половину записи
+			std::string path = Path(key), temporary = path + ".tmp" + std::to_string(std::random_device()());
+			bool written = false;
+			{
+				std::ofstream file(temporary, std::ios::binary);
+				written = static_cast<bool>(file.write(text->data(), static_cast<std::streamsize>(text->size())));
+			}
+			std::error_code error;
+			if (written) std::filesystem::rename(temporary, path, error);
+			if (!written || error) std::filesystem::remove(temporary, error);
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		Remember(key, std::move(text));
+	}
+
+	DerivativeCache::Text DerivativeCache::Derivative(Func* f, const Options& options) {
+		// переменная и производная создаются в текущем хранилище; функция из другого 
+		// отвергается до поиска, чтобы в кэш не попало ничего, вычисленного с ней
+		if (!FuncStore::Current().Contains(f)) throw std::runtime_error("cache: function is not from the current store");
+		Key key = MakeKey(f, options);
+		if (Text text = Find(key)) return text;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			++stats.misses;
+		}
+		Func* var = options.variable == "x" ? Make<X>() : Make<Var>(options.variable);
+		Func* d = options.simplify ? Simplify(f) : f;
+		for (int i = 0; i < options.order; ++i) {
+			d = d->Der(var);
+			if (options.simplify) d = Simplify(d);
+		}
+		std::ostringstream os;
+		os << *d;
+		Text text = std::make_shared<const std::string>(os.str());
+		Insert(key, text);
+		return text;
+	}
+
+	Statistics DerivativeCache::Stats() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return stats;
+	}
+
+	void DerivativeCache::Clear() {
+		std::lock_guard<std::mutex> lock(mutex);
+		order.clear();
+		entries.clear();
+		stats.bytes = 0;
+		stats.entries = 0;
+	}
+}
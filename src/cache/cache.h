@@ -0,0 +1,139 @@
+﻿#ifndef CACHE_CACHE_H_20261018
+#define CACHE_CACHE_H_20261018
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <functions/functions.h>
+
+/// Пространство имен, содержащее кэш производных
+namespace cache {
+
+	/*!
+	\brief Ключ кэша: 128-битный структурный хэш функции вместе с параметрами производной
+
+	Хэш считается по типам, числам, именам переменных и аргументам, а не по указателям
+	и не по Func::hash, поэтому один и тот же ключ получается в любом хранилище, в любом
+	запуске и в любой сборке
+	*/
+	struct Key {
+		/// Младшие 64 бита
+		std::uint64_t lo;
+		/// Старшие 64 бита
+		std::uint64_t hi;
+		bool operator==(const Key& other) const noexcept { return lo == other.lo && hi == other.hi; }
+		/// Запись ключа 32 шестнадцатеричными цифрами
+		std::string Hex() const;
+	};
+
+	/// Параметры производной
+	struct Options {
+		/// Порядок производной, 0 - сама функция
+		int order{ 1 };
+		/// Переменная дифференцирования
+		std::string variable{ "x" };
+		/// Упрощать функцию и каждую производную
+		bool simplify{ false };
+	};
+
+	/*!
+	\brief Функция вычисляет ключ производной функции обходом с явным стеком
+	\param[in] f функция
+	\param[in] options параметры производной
+	\return Key ключ
+	*/
+	Key MakeKey(Func* f, const Options& options);
+
+	/// Счетчики кэша
+	struct Statistics {
+		/// Найдено в памяти
+		std::uint64_t hits{ 0 };
+		/// Найдено на диске
+		std::uint64_t disk_hits{ 0 };
+		/// Не найдено: производная вычислена
+		std::uint64_t misses{ 0 };
+		/// Вытеснено из памяти
+		std::uint64_t evictions{ 0 };
+		/// Записей в памяти
+		std::uint64_t entries{ 0 };
+		/// Байт в памяти с учетом служебных данных записей
+		std::uint64_t bytes{ 0 };
+	};
+
+	/*!
+	\brief Кэш записей производных с уровнем в памяти и необязательным уровнем на диске
+
+	При попадании Der(), Simplify() и печать не выполняются: возвращается готовая запись.
+	В памяти записи вытесняются по давности использования (LRU), пока их объем больше
+	бюджета. Уровень на диске - каталог, где каждая запись лежит в файле с именем ключа;
+	он переживает запуск программы и не ограничивается. Методы можно вызывать из
+	нескольких потоков; производная при промахе вычисляется вне блокировки.
+
+	Пример
+	\code
+	cache::DerivativeCache derivatives(64 << 20, "derivatives");
+	Func* f = simpleparser::Parser("sin(x) ^ 2").Parse();
+	std::cout << *derivatives.Derivative(f, { 2 }) << '\n';
+	\endcode
+	*/
+	class DerivativeCache {
+	public:
+		/// Запись производной, которую можно хранить дольше самого кэша
+		using Text = std::shared_ptr<const std::string>;
+		/*!
+		\brief Конструктор кэша
+		\param[in] budget наибольший объем записей в памяти в байтах
+		\param[in] directory каталог уровня на диске; пустая строка - только память
+		*/
+		explicit DerivativeCache(size_t budget, std::string directory = {});
+		DerivativeCache(const DerivativeCache&) = delete;
+		DerivativeCache& operator=(const DerivativeCache&) = delete;
+		/*!
+		\brief Метод получает запись производной, вычисляя ее при промахе
+		\param[in] f функция из FuncStore::Current()
+		\param[in] options параметры производной
+		\throw std::runtime_error если f не из FuncStore::Current()
+		\return Text запись производной, та же, что у operator<<
+		*/
+		Text Derivative(Func* f, const Options& options = {});
+		/*!
+		\brief Метод ищет запись в памяти, затем на диске
+		\param[in] key ключ
+		\return Text запись либо nullptr
+		*/
+		Text Find(const Key& key);
+		/*!
+		\brief Метод добавляет запись в память и на диск
+		\param[in] key ключ
+		\param[in] text запись
+		*/
+		void Insert(const Key& key, Text text);
+		/// Счетчики кэша
+		Statistics Stats() const;
+		/// Метод очищает уровень в памяти; файлы на диске остаются
+		void Clear();
+	private:
+		struct KeyHash {
+			size_t operator()(const Key& key) const noexcept { return static_cast<size_t>(key.lo); }
+		};
+		using Entry = std::pair<Key, Text>;
+		static size_t Cost(const Text& text) noexcept;
+		std::string Path(const Key& key) const;
+		void Remember(const Key& key, Text text);
+		size_t budget;
+		std::string directory;
+		mutable std::mutex mutex;
+		// записи от недавних к давним
+		std::list<Entry> order;
+		std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> entries;
+		Statistics stats;
+	};
+}
+
+#endif // !CACHE_CACHE_H_20261018
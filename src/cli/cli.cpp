@@ -0,0 +1,135 @@
+﻿#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <functions/stats.h>
+#include <parser/parser.h>
+
+namespace {
+	const char* usage =
+		"usage: cli [-n order] [-d variable] [-s] [-t] [-p point]... [file]\n"
+		"\n"
+		"Reads one function per line from file (or stdin) and writes one line per function:\n"
+		"its derivative, followed by tab-separated values of the derivative at the points.\n"
+		"Lines that fail to parse are written as \"error: <message> at <column>\".\n"
+		"\n"
+		"  -n order     order of the derivative, 0 writes the function itself (default 1)\n"
+		"  -d variable  differentiate by this variable (default x)\n"
+		"  -s           simplify the function and every derivative\n"
+		"  -t           write node, allocation and time counters as JSON to stderr\n"
+		"               (needs a build with DERIVATIVE_STATS)\n"
+		"  -p point     value of x to evaluate the derivative at; may be repeated.\n"
+		"               Points give only x, so -p cannot be combined with -d other than x;\n"
+		"               other variables of the function evaluate to nan\n";
+
+	struct Options {
+		int order{ 1 };
+		std::string variable{ "x" };
+		bool simplify{ false };
+		bool stats{ false };
+		std::vector<double> points;
+		const char* file{ nullptr };
+	};
+
+	bool Number(const char* text, double& value) {
+		char* end = nullptr;
+		value = std::strtod(text, &end);
+		return end != text && *end == '\0';
+	}
+
+	bool ParseOptions(int argc, char* argv[], Options& options) {
+		for (int i = 1; i < argc; ++i) {
+			std::string arg(argv[i]);
+			bool value = i + 1 < argc;
+			if (arg == "-s") options.simplify = true;
+			else if (arg == "-t") options.stats = true;
+			else if (arg == "-n" && value) {
+				double order = 0.0;
+				// диапазон проверяется до приведения: приведение большого числа или nan к int - UB
+				if (!Number(argv[++i], order) || !(order >= 0 && order <= INT_MAX)) return false;
+				if (order != static_cast<int>(order)) return false;
+				options.order = static_cast<int>(order);
+			}
+			else if (arg == "-d" && value) options.variable = argv[++i];
+			else if (arg == "-p" && value) {
+				double point = 0.0;
+				if (!Number(argv[++i], point)) return false;
+				options.points.push_back(point);
+			}
+			else if (arg == "-h" || arg == "--help") return false;
+			else if (arg[0] != '-' || arg == "-") {
+				if (options.file) return false;
+				options.file = argv[i];
+			}
+			else return false;
+		}
+		// производная по другой переменной зависит от ее значения, а точки задают только x
+		return options.points.empty() || options.variable == "x";
+	}
+
+	// строка обрабатывается в своем хранилище, поэтому память не растет с числом строк
+	bool Process(const std::string& line, const Options& options, std::ostream& out) {
+		FuncStore store;
+		FuncStore::Scope scope(store);
+		simpleparser::Parser parser(line);
+		simpleparser::ParseResult result = parser.TryParse();
+		if (!result) {
+			out << "error: " << result.error << " at " << result.offset + 1 << '\n';
+			return false;
+		}
+		Func* var = options.variable == "x" ? Make<X>() : Make<Var>(options.variable);
+		Func* f = options.simplify ? Simplify(result.func) : result.func;
+		for (int i = 0; i < options.order; ++i) {
+			f = f->Der(var);
+			if (options.simplify) f = Simplify(f);
+		}
+		out << *f;
+		if (options.points.empty()) {
+			out << '\n';
+			return true;
+		}
+		// Eval() обходит функцию без рекурсии, поэтому глубокие функции не переполняют стек
+		for (double point : options.points) {
+			char value[32];
+			std::snprintf(value, sizeof(value), "\t%.17g", f->Eval(point));
+			out << value;
+		}
+		out << '\n';
+		return true;
+	}
+}
+
+int main(int argc, char* argv[]) {
+	Options options;
+	if (!ParseOptions(argc, argv, options)) {
+		std::cerr << usage;
+		return 2;
+	}
+	std::ifstream file;
+	if (options.file && std::string(options.file) != "-") {
+		file.open(options.file);
+		if (!file) {
+			std::cerr << "cli: cannot open " << options.file << '\n';
+			return 2;
+		}
+	}
+	std::istream& in = file.is_open() ? file : std::cin;
+	std::ios::sync_with_stdio(false);
+	std::string line;
+	size_t errors = 0;
+	while (std::getline(in, line)) {
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+		if (line.find_first_not_of(" \t") == std::string::npos) {
+			std::cout << '\n';
+			continue;
+		}
+		if (!Process(line, options, std::cout)) ++errors;
+	}
+	std::cout.flush();
+	if (options.stats) stats::Dump(std::cerr);
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,300 @@
+﻿#include <codegen/codegen.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace codegen {
+	namespace {
+		// как функция печатается в repr()
+		enum class Kind {
+			LEAF,       // без аргументов: число, константа, x или сокращение до 0 и 1
+			ALIAS,      // как один из аргументов, например 1 * f
+			NEGATION,   // -f
+			OPERATION   // операция над всеми аргументами
+		};
+
+		struct Node {
+			Kind kind;
+			const Func* args[2];
+			int arity;
+			// функция, которая печатается на самом деле (для ALIAS - конец цепочки сокращений)
+			const Func* target;
+			std::uint32_t uses;
+			bool visited;
+		};
+
+		// Подфункции в том виде, в котором их печатает repr(): структура берется из
+		// Print(), поэтому сокращения вроде 0 * f не порождают лишних переменных
+		class Graph {
+		public:
+			Graph(const std::vector<Func*>& roots, const std::vector<std::string>& results);
+			const Func* Resolve(const Func* f);
+			const Node& At(const Func* f) const { return nodes.at(f); }
+			// временные переменные в порядке вычисления
+			std::vector<const Func*> temporaries;
+			// имена временных переменных, в том числе для сокращений, печатающихся как они
+			std::unordered_map<const Func*, std::string> names;
+			// имена переменных функций: временные переменные и результаты их не занимают
+			std::unordered_set<std::string> variables;
+		private:
+			Node& Visit(const Func* f);
+			Printer printer;
+			std::unordered_map<const Func*, Node> nodes;
+			std::vector<Node*> chain;
+		};
+
+		Graph::Graph(const std::vector<Func*>& roots, const std::vector<std::string>& results) {
+			// обратный порядок обхода без рекурсии, как в bytecode::Program
+			std::vector<const Func*> order;
+			std::vector<std::pair<const Func*, bool>> stack;
+			for (Func* root : roots) {
+				const Func* f = Resolve(root);
+				++Visit(f).uses;
+				stack.push_back({ f, false });
+			}
+			while (!stack.empty()) {
+				auto [f, expanded] = stack.back();
+				stack.pop_back();
+				if (expanded) {
+					order.push_back(f);
+					continue;
+				}
+				Node& node = Visit(f);
+				if (node.visited) continue;
+				node.visited = true;
+				stack.push_back({ f, true });
+				for (int i = node.arity - 1; i >= 0; --i) {
+					const Func* arg = Resolve(node.args[i]);
+					Node& child = Visit(arg);
+					++child.uses;
+					if (!child.visited) stack.push_back({ arg, false });
+				}
+			}
+			for (const Func* f : order) {
+				if (f->type == FuncType::X) variables.insert("x");
+				if (f->type == FuncType::VAR) variables.insert(static_cast<const Var*>(f)->Name());
+			}
+			std::unordered_set<std::string> taken(results.begin(), results.end());
+			size_t next = 0;
+			for (const Func* f : order) {
+				const Node& node = At(f);
+				if (node.kind == Kind::LEAF || node.uses < 2) continue;
+				// t1, t2, ..., пропуская имена переменных функций и результатов
+				std::string name;
+				do name = "t" + std::to_string(++next);
+				while (variables.count(name) || taken.count(name));
+				temporaries.push_back(f);
+				names.emplace(f, std::move(name));
+			}
+			for (const auto& [f, node] : nodes) {
+				if (node.kind != Kind::ALIAS) continue;
+				auto found = names.find(node.target);
+				if (found != names.end()) names.emplace(f, found->second);
+			}
+		}
+
+		Node& Graph::Visit(const Func* f) {
+			auto found = nodes.find(f);
+			if (found != nodes.end()) return found->second;
+			const std::vector<Printer::Piece>& parts = printer.Parts(f);
+			Node node{ Kind::LEAF, { nullptr, nullptr }, 0, f, 0, false };
+			for (const Printer::Piece& piece : parts)
+				if (piece.f && node.arity < 2) node.args[node.arity++] = piece.f;
+			if (node.arity == 0) node.kind = Kind::LEAF;
+			else if (parts.size() == 1) node.kind = Kind::ALIAS;
+			else if (parts.size() == 2 && parts[0].text == "-") node.kind = Kind::NEGATION;
+			else node.kind = Kind::OPERATION;
+			return nodes.emplace(f, node).first->second;
+		}
+
+		const Func* Graph::Resolve(const Func* f) {
+			// цепочка сокращений проходится без рекурсии и запоминается
+			chain.clear();
+			for (;;) {
+				Node& node = Visit(f);
+				if (node.kind != Kind::ALIAS) break;
+				if (node.target != f) {
+					f = node.target;
+					break;
+				}
+				chain.push_back(&node);
+				f = node.args[0];
+			}
+			for (Node* node : chain) node->target = f;
+			return f;
+		}
+
+		// Запись выражений C++ с явным стеком
+		class CppWriter {
+		public:
+			explicit CppWriter(Graph& graph) : graph(graph) {}
+			void Run(const Func* f, std::string& buffer);
+		private:
+			struct Item {
+				const Func* f;
+				const char* text;
+			};
+			int Precedence(const Func* f) const;
+			void Expand(const Func* f, std::string& buffer);
+			void Add(const Func* f, bool brackets);
+			Graph& graph;
+			std::vector<Item> items;
+			std::vector<Item> stack;
+		};
+
+		void Literal(float value, std::string& buffer) {
+			// кратчайшая запись, из которой получается то же число float
+			char str[64];
+			if (value == std::floor(value) && std::fabs(value) < 1e9f) std::snprintf(str, sizeof(str), "%.0f", value);
+			else for (int precision = 1; precision <= 9; ++precision) {
+				std::snprintf(str, sizeof(str), "%.*g", precision, value);
+				if (std::strtof(str, nullptr) == value) break;
+			}
+			buffer += str;
+			if (!std::strpbrk(str, ".en")) buffer += ".0";
+		}
+
+		int Precedence(FuncType type) {
+			switch (type) {
+			case FuncType::SUM:
+			case FuncType::SUB: return 1;
+			case FuncType::MULT:
+			case FuncType::DIVISION:
+			case FuncType::CTG: return 2;
+			default: return 4;
+			}
+		}
+
+		int CppWriter::Precedence(const Func* f) const {
+			if (graph.names.count(f)) return 4;
+			const Node& node = graph.At(f);
+			if (node.kind == Kind::NEGATION) return 3;
+			if (node.kind == Kind::OPERATION) return codegen::Precedence(f->type);
+			if (f->type == FuncType::NUM && std::signbit(static_cast<const Num*>(f)->Value())) return 3;
+			return 4;
+		}
+
+		void CppWriter::Add(const Func* f, bool brackets) {
+			if (brackets) items.push_back({ nullptr, "(" });
+			items.push_back({ f, nullptr });
+			if (brackets) items.push_back({ nullptr, ")" });
+		}
+
+		void CppWriter::Expand(const Func* f, std::string& buffer) {
+			const Node& node = graph.At(f);
+			items.clear();
+			if (node.kind == Kind::LEAF) {
+				switch (f->type) {
+				case FuncType::X: buffer += "x"; break;
+				case FuncType::VAR: buffer += static_cast<const Var*>(f)->Name(); break;
+				case FuncType::E: buffer += "2.718281828459045"; break;
+				case FuncType::PI: buffer += "3.141592653589793"; break;
+				case FuncType::NUM: Literal(static_cast<const Num*>(f)->Value(), buffer); break;
+				default: buffer += f->one ? "1.0" : "0.0";
+				}
+				return;
+			}
+			const Func* a = graph.Resolve(node.args[0]);
+			if (node.kind == Kind::NEGATION) {
+				// -(-x), а не --x
+				items.push_back({ nullptr, "-" });
+				Add(a, Precedence(a) <= 3);
+			}
+			else if (node.arity == 2 && f->type != FuncType::POW) {
+				const Func* b = graph.Resolve(node.args[1]);
+				int precedence = codegen::Precedence(f->type);
+				Add(a, Precedence(a) < precedence);
+				items.push_back({ nullptr,
+					f->type == FuncType::SUM ? " + " : f->type == FuncType::SUB ? " - " : f->type == FuncType::MULT ? " * " : " / " });
+				Add(b, Precedence(b) <= precedence);
+			}
+			else {
+				switch (f->type) {
+				case FuncType::POW: items.push_back({ nullptr, "std::pow(" }); break;
+				case FuncType::SIN: items.push_back({ nullptr, "std::sin(" }); break;
+				case FuncType::COS: items.push_back({ nullptr, "std::cos(" }); break;
+				case FuncType::TG: items.push_back({ nullptr, "std::tan(" }); break;
+				case FuncType::CTG: items.push_back({ nullptr, "1.0 / std::tan(" }); break;
+				case FuncType::LN: items.push_back({ nullptr, "std::log(" }); break;
+				case FuncType::LG: items.push_back({ nullptr, "std::log10(" }); break;
+				default: items.push_back({ nullptr, "std::sqrt(" });
+				}
+				Add(a, false);
+				if (node.arity == 2) {
+					items.push_back({ nullptr, ", " });
+					Add(graph.Resolve(node.args[1]), false);
+				}
+				items.push_back({ nullptr, ")" });
+			}
+			stack.insert(stack.end(), items.rbegin(), items.rend());
+		}
+
+		void CppWriter::Run(const Func* f, std::string& buffer) {
+			stack.clear();
+			Expand(f, buffer);
+			while (!stack.empty()) {
+				Item item = stack.back();
+				stack.pop_back();
+				if (!item.f) {
+					buffer += item.text;
+					continue;
+				}
+				auto found = graph.names.find(item.f);
+				if (found != graph.names.end()) buffer += found->second;
+				else Expand(item.f, buffer);
+			}
+		}
+	}
+
+	void Write(const std::vector<Func*>& roots, const std::vector<std::string>& names, std::ostream& os, Language language) {
+		constexpr size_t chunk = 1 << 16;
+		Graph graph(roots, names);
+		for (const std::string& name : names)
+			if (graph.variables.count(name)) throw std::runtime_error("codegen: result name " + name + " is a variable of the function");
+		Printer printer;
+		printer.Names(&graph.names);
+		CppWriter writer(graph);
+		std::string buffer;
+		auto statement = [&](const std::string& name, const Func* f, bool result) {
+			if (language == Language::CPP) buffer += "const double ";
+			buffer += name;
+			buffer += " = ";
+			const Func* target = graph.Resolve(f);
+			auto found = graph.names.find(target);
+			if (result && found != graph.names.end()) buffer += found->second;
+			else if (language == Language::CPP) writer.Run(target, buffer);
+			else buffer += printer.Run(f);
+			buffer += language == Language::CPP ? ";\n" : "\n";
+			if (buffer.size() >= chunk) {
+				os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+				buffer.clear();
+			}
+		};
+		for (const Func* f : graph.temporaries) statement(graph.names.at(f), f, false);
+		for (size_t i = 0; i < roots.size(); ++i) statement(names.at(i), roots[i], true);
+		os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+	}
+
+	std::string Generate(Func* f, Language language) {
+		std::vector<Func*> vars = Variables(f);
+		auto taken = [&vars](const std::string& name) {
+			for (Func* var : vars)
+				if (var->type == FuncType::VAR && static_cast<const Var*>(var)->Name() == name) return true;
+			return false;
+		};
+		std::string name = "result";
+		for (int i = 1; taken(name); ++i) name = "result" + std::to_string(i);
+		std::ostringstream os;
+		Write({ f }, { name }, os, language);
+		return os.str();
+	}
+}
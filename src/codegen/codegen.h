@@ -0,0 +1,65 @@
+﻿#ifndef CODEGEN_CODEGEN_H_20261018
+#define CODEGEN_CODEGEN_H_20261018
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include <functions/functions.h>
+
+/// Пространство имен, содержащее запись функций с вынесенными общими подфункциями
+namespace codegen {
+
+	/// Перечисление, содержащее форматы записи
+	enum class Language {
+		/// Запись repr(): t1 = cos(x)
+		TEXT,
+		/// Фрагмент C/C++: const double t1 = std::cos(x);
+		CPP
+	};
+
+	/*!
+	\brief Функция записывает функции, вынося общие подфункции во временные переменные
+
+	Der() переиспользует аргументы, поэтому одна и та же подфункция встречается в
+	записи производной много раз, и длина repr() растет экспоненциально с порядком
+	производной. Здесь каждая подфункция, которая печатается больше одного раза,
+	записывается один раз в переменную t1, t2, ..., а дальше используется по имени,
+	поэтому длина записи линейна по числу различных подфункций.
+
+	Учитываются те же сокращения, что и в repr() (0 * f печатается как 0 и т.д.).
+	Номера временных переменных, совпадающие с именем переменной функции или 
+	результата, пропускаются: при переменной t1 временные - t2, t3, ....
+	Фрагмент C/C++ использует переменные double с именами переменных функции (x и Var)
+	и функции из <cmath>, скобки расставляются по приоритетам C++.
+
+	Пример
+	\code
+	Func* f = simpleparser::Parser("sin(x) ^ 3 * cos(x)").Parse();
+	std::cout << codegen::Generate(f->Der());
+	// t1 = sin(x)
+	// t2 = cos(x)
+	// result = t1 ^ (3 - 1) * 3 * t2 * t2 + t1 ^ 3 * (-t1)
+	codegen::Write({ f, f->Der() }, { "f", "df" }, std::cout, codegen::Language::CPP);
+	\endcode
+	\param[in] roots функции
+	\param[in] names имена результатов, по одному на функцию
+	\param[out] os поток
+	\param[in] language формат записи
+	\throw std::runtime_error если имя результата совпадает с именем переменной функции
+	*/
+	void Write(const std::vector<Func*>& roots, const std::vector<std::string>& names, std::ostream& os,
+		Language language = Language::TEXT);
+
+	/*!
+	\brief Функция записывает одну функцию с результатом result
+
+	Если у функции есть переменная result, результат называется result1 (result2, ...)
+	\param[in] f функция
+	\param[in] language формат записи
+	\return std::string запись
+	*/
+	std::string Generate(Func* f, Language language = Language::TEXT);
+}
+
+#endif // !CODEGEN_CODEGEN_H_20261018
@@ -0,0 +1,158 @@
+﻿#include <functions/dual.h>
+
+#include <algorithm>
+
+// Коэффициенты результата считаются стандартными рекуррентными формулами
+// для рядов Тейлора, порядок результата - наименьший из порядков аргументов
+
+Jet::Jet(double value, int n) : order(std::min(n, capacity)) {
+	c[0] = value;
+}
+
+Jet Jet::Variable(double x, int n) {
+	Jet r(x, n);
+	if (r.order > 0) r.c[1] = 1.0;
+	return r;
+}
+
+double Jet::Derivative(int k) const noexcept {
+	double r = c[k];
+	for (int i = 2; i <= k; ++i) r *= i;
+	return r;
+}
+
+bool Jet::Constant() const noexcept {
+	for (int k = 1; k <= order; ++k)
+		if (c[k] != 0.0) return false;
+	return true;
+}
+
+Jet operator+(const Jet& a, const Jet& b) {
+	Jet r(0.0, std::min(a.Order(), b.Order()));
+	for (int k = 0; k <= r.Order(); ++k) r[k] = a[k] + b[k];
+	return r;
+}
+
+Jet operator-(const Jet& a, const Jet& b) {
+	Jet r(0.0, std::min(a.Order(), b.Order()));
+	for (int k = 0; k <= r.Order(); ++k) r[k] = a[k] - b[k];
+	return r;
+}
+
+Jet operator*(const Jet& a, const Jet& b) {
+	Jet r(0.0, std::min(a.Order(), b.Order()));
+	for (int k = 0; k <= r.Order(); ++k) {
+		double s = 0.0;
+		for (int i = 0; i <= k; ++i) s += a[i] * b[k - i];
+		r[k] = s;
+	}
+	return r;
+}
+
+Jet operator/(const Jet& a, const Jet& b) {
+	Jet r(0.0, std::min(a.Order(), b.Order()));
+	for (int k = 0; k <= r.Order(); ++k) {
+		double s = a[k];
+		for (int i = 1; i <= k; ++i) s -= b[i] * r[k - i];
+		r[k] = s / b[0];
+	}
+	return r;
+}
+
+Jet exp(const Jet& a) {
+	Jet r(std::exp(a[0]), a.Order());
+	for (int k = 1; k <= r.Order(); ++k) {
+		double s = 0.0;
+		for (int i = 1; i <= k; ++i) s += i * a[i] * r[k - i];
+		r[k] = s / k;
+	}
+	return r;
+}
+
+namespace {
+	void SinCos(const Jet& a, Jet& s, Jet& c) {
+		s = Jet(std::sin(a[0]), a.Order());
+		c = Jet(std::cos(a[0]), a.Order());
+		for (int k = 1; k <= a.Order(); ++k) {
+			double ds = 0.0, dc = 0.0;
+			for (int i = 1; i <= k; ++i) {
+				ds += i * a[i] * c[k - i];
+				dc -= i * a[i] * s[k - i];
+			}
+			s[k] = ds / k;
+			c[k] = dc / k;
+		}
+	}
+}
+
+Jet sin(const Jet& a) {
+	Jet s, c;
+	SinCos(a, s, c);
+	return s;
+}
+
+Jet cos(const Jet& a) {
+	Jet s, c;
+	SinCos(a, s, c);
+	return c;
+}
+
+Jet tan(const Jet& a) {
+	Jet s, c;
+	SinCos(a, s, c);
+	Jet r = s / c;
+	r[0] = std::tan(a[0]);
+	return r;
+}
+
+Jet log(const Jet& a) {
+	Jet r(std::log(a[0]), a.Order());
+	for (int k = 1; k <= r.Order(); ++k) {
+		double s = a[k];
+		for (int i = 1; i < k; ++i) s -= i * r[i] * a[k - i] / k;
+		r[k] = s / a[0];
+	}
+	return r;
+}
+
+Jet log10(const Jet& a) {
+	Jet r = log(a);
+	for (int k = 0; k <= r.Order(); ++k) r[k] /= std::log(10.0);
+	r[0] = std::log10(a[0]);
+	return r;
+}
+
+Jet sqrt(const Jet& a) {
+	Jet r(std::sqrt(a[0]), a.Order());
+	for (int k = 1; k <= r.Order(); ++k) {
+		double s = a[k];
+		for (int i = 1; i < k; ++i) s -= r[i] * r[k - i];
+		r[k] = s / (2 * r[0]);
+	}
+	return r;
+}
+
+Jet pow(const Jet& a, const Jet& b) {
+	int n = std::min(a.Order(), b.Order());
+	if (!b.Constant()) return exp(b * log(a));
+	double e = b[0];
+	if (e == std::floor(e) && std::fabs(e) <= 64) {
+		// возведение в квадрат и умножение
+		Jet r(1.0, n), base = a;
+		for (long long m = static_cast<long long>(std::fabs(e)); m > 0; m >>= 1) {
+			if (m & 1) r = r * base;
+			if (m > 1) base = base * base;
+		}
+		if (e < 0) r = Jet(1.0, n) / r;
+		r[0] = std::pow(a[0], e);
+		return r;
+	}
+	// (a^e)' a = e a' a^e
+	Jet r(std::pow(a[0], e), n);
+	for (int k = 1; k <= n; ++k) {
+		double s = 0.0;
+		for (int i = 1; i <= k; ++i) s += (e * i - (k - i)) * a[i] * r[k - i];
+		r[k] = s / (k * a[0]);
+	}
+	return r;
+}
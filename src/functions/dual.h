@@ -0,0 +1,120 @@
+﻿#ifndef FUNCTIONS_DUAL_H_20261018
+#define FUNCTIONS_DUAL_H_20261018
+
+#include <cmath>
+
+/*!
+\brief Дуальное число \f$value + der \cdot \varepsilon, \varepsilon^2 = 0\f$
+
+Вычисление функции от Dual::Variable(x) дает значение и первую производную
+за один проход без построения дерева Der()
+*/
+struct Dual {
+	/// Значение
+	double value;
+	/// Производная
+	double der;
+	/// Независимая переменная в точке x
+	static Dual Variable(double x) { return { x, 1.0 }; }
+};
+
+inline Dual operator+(const Dual& a, const Dual& b) { return { a.value + b.value, a.der + b.der }; }
+inline Dual operator-(const Dual& a, const Dual& b) { return { a.value - b.value, a.der - b.der }; }
+inline Dual operator*(const Dual& a, const Dual& b) { return { a.value * b.value, a.der * b.value + a.value * b.der }; }
+inline Dual operator/(const Dual& a, const Dual& b) {
+	return { a.value / b.value, (a.der * b.value - a.value * b.der) / (b.value * b.value) };
+}
+inline Dual sin(const Dual& a) { return { std::sin(a.value), std::cos(a.value) * a.der }; }
+inline Dual cos(const Dual& a) { return { std::cos(a.value), -std::sin(a.value) * a.der }; }
+inline Dual tan(const Dual& a) {
+	double c = std::cos(a.value);
+	return { std::tan(a.value), a.der / (c * c) };
+}
+inline Dual log(const Dual& a) { return { std::log(a.value), a.der / a.value }; }
+inline Dual log10(const Dual& a) { return { std::log10(a.value), a.der / (a.value * std::log(10.0)) }; }
+inline Dual sqrt(const Dual& a) {
+	double r = std::sqrt(a.value);
+	return { r, a.der / (2 * r) };
+}
+/*!
+\brief \f$(a^b)' = ba^{b-1}a' + b'a^b ln a\f$
+
+Слагаемые с нулевыми a' или b' опускаются, поэтому \f$x^2\f$ дифференцируется
+и при отрицательных x, где \f$ln a\f$ не определен
+*/
+inline Dual pow(const Dual& a, const Dual& b) {
+	double value = std::pow(a.value, b.value);
+	double der = 0.0;
+	if (a.der != 0.0) der += b.value * std::pow(a.value, b.value - 1) * a.der;
+	if (b.der != 0.0) der += b.der * value * std::log(a.value);
+	return { value, der };
+}
+
+/*!
+\brief Усеченный ряд Тейлора \f$\sum_{k=0}^{n} c_k t^k\f$ порядка n <= capacity
+
+Вычисление функции от Jet::Variable(x, n) дает коэффициенты Тейлора функции в
+точке x, то есть \f$f^{(k)}(x) / k!\f$ для всех k <= n, за один проход. Коэффициенты
+хранятся внутри объекта, поэтому операции над рядами не выделяют память.
+
+Пример
+\code
+Jet r = f->Eval(Jet::Variable(0.5, 4));
+double f3 = r.Derivative(3); // f'''(0.5)
+\endcode
+*/
+class Jet {
+public:
+	/// Наибольший поддерживаемый порядок
+	static constexpr int capacity = 16;
+	/// Конструктор по умолчанию: нулевой ряд порядка 0
+	Jet() = default;
+	/*!
+	\brief Конструктор константы
+	\param[in] value значение
+	\param[in] n порядок ряда, не больше capacity
+	*/
+	Jet(double value, int n);
+	/*!
+	\brief Метод создает независимую переменную \f$x + t\f$
+	\param[in] x точка
+	\param[in] n порядок ряда, не больше capacity
+	\return Jet
+	*/
+	static Jet Variable(double x, int n);
+	/// Порядок ряда
+	int Order() const noexcept { return order; }
+	/// Коэффициент при \f$t^k\f$
+	double operator[](int k) const noexcept { return c[k]; }
+	/// Коэффициент при \f$t^k\f$
+	double& operator[](int k) noexcept { return c[k]; }
+	/// Производная порядка k: \f$k! c_k\f$
+	double Derivative(int k) const noexcept;
+	/// Ряд не зависит от переменной
+	bool Constant() const noexcept;
+private:
+	double c[capacity + 1]{};
+	int order{ 0 };
+};
+
+Jet operator+(const Jet& a, const Jet& b);
+Jet operator-(const Jet& a, const Jet& b);
+Jet operator*(const Jet& a, const Jet& b);
+Jet operator/(const Jet& a, const Jet& b);
+Jet exp(const Jet& a);
+Jet sin(const Jet& a);
+Jet cos(const Jet& a);
+Jet tan(const Jet& a);
+Jet log(const Jet& a);
+Jet log10(const Jet& a);
+Jet sqrt(const Jet& a);
+/*!
+\brief Степень рядов
+
+Целый постоянный показатель (до 64 по модулю) возводится умножениями и допускает
+любое основание, прочий постоянный показатель - рекуррентно при ненулевом основании,
+в остальных случаях \f$a^b = e^{b ln a}\f$
+*/
+Jet pow(const Jet& a, const Jet& b);
+
+#endif // !FUNCTIONS_DUAL_H_20261018
@@ -1,185 +1,616 @@
-#include <functions/functions.h>
+﻿#include <functions/functions.h>
+#include <functions/stats.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+
+namespace {
+	std::uint64_t Mix(std::uint64_t h, std::uint64_t v) {
+		h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+		return h;
+	}
+
+	thread_local FuncStore* current_store{ nullptr };
+
+	// значения подфункций при вычислении: открытая адресация по структурному хэшу, 
+	// как в таблице хранилища; память переиспользуется вызовами в потоке
+	template <class T>
+	class Values {
+	public:
+		void Reset() {
+			// большую таблицу проще освободить, чем держать до конца потока
+			if (keys.size() > 4096) {
+				keys.clear();
+				values.clear();
+			}
+			else for (size_t i : used) keys[i] = nullptr;
+			used.clear();
+			if (keys.empty()) Resize(64);
+		}
+		const T* Find(const Func* f) const noexcept {
+			for (size_t i = static_cast<size_t>(f->hash) & mask; keys[i]; i = (i + 1) & mask)
+				if (keys[i] == f) return &values[i];
+			return nullptr;
+		}
+		void Insert(const Func* f, const T& value) {
+			if (2 * (used.size() + 1) > keys.size()) Resize(2 * keys.size());
+			size_t i = static_cast<size_t>(f->hash) & mask;
+			while (keys[i]) i = (i + 1) & mask;
+			keys[i] = f;
+			values[i] = value;
+			used.push_back(i);
+		}
+	private:
+		void Resize(size_t size) {
+			std::vector<const Func*> old_keys(size, nullptr);
+			std::vector<T> old_values(size);
+			old_keys.swap(keys);
+			old_values.swap(values);
+			std::vector<size_t> old_used;
+			old_used.swap(used);
+			mask = size - 1;
+			for (size_t i : old_used) Insert(old_keys[i], old_values[i]);
+		}
+		std::vector<const Func*> keys;
+		std::vector<T> values;
+		std::vector<size_t> used;
+		size_t mask{ 0 };
+	};
+}
+
+// FUNC
+
+Func::Func(FuncType t, const Func* f1, const Func* f2) : type(t) {
+	constant = t != FuncType::X && t != FuncType::VAR && (!f1 || f1->constant) && (!f2 || f2->constant);
+	hash = Mix(0xcbf29ce484222325ull, static_cast<std::uint64_t>(t));
+	if (f1) hash = Mix(hash, f1->hash);
+	if (f2) hash = Mix(hash, f2->hash);
+}
+
+Func* Func::Der() {
+	return Der(Make<X>());
+}
+
+Func* Func::Der(const Func* var) {
+	FuncStore& store = FuncStore::Current();
+	// в памяти только ключи этого хранилища, поэтому поиск до проверки безопасен
+	if (Func* der = store.Memo(this, var)) return der;
+	// производная строится из аргументов функции и запоминается по указателям, 
+	// поэтому функция и переменная из другого хранилища отвергаются, как в кэше
+	if (!store.Contains(this) || !store.Contains(var)) throw std::runtime_error("der: function is not from the current store");
+	DERIVATIVE_STATS_ONLY(stats::Shape before = stats::Measure(this));
+	{
+		DERIVATIVE_STATS_ONLY(stats::Timer timer(stats::Phase::DIFFERENTIATE));
+		// аргументы дифференцируются раньше функции, поэтому вызовы Der() внутри 
+		// Differentiate(var) находят готовые производные и не уходят вглубь
+		std::vector<std::pair<Func*, bool>> stack{ { this, false } };
+		while (!stack.empty()) {
+			auto [f, expanded] = stack.back();
+			if (expanded) {
+				stack.pop_back();
+				if (!store.Memo(f, var)) store.Memoize(f, var, f->Differentiate(var));
+				continue;
+			}
+			stack.back().second = true;
+			for (int i = f->Arity() - 1; i >= 0; --i)
+				if (!store.Memo(f->Arg(i), var)) stack.push_back({ f->Arg(i), false });
+		}
+	}
+	Func* der = store.Memo(this, var);
+	DERIVATIVE_STATS_ONLY(stats::Record(before, stats::Measure(der)));
+	return der;
+}
+
+template <class T>
+T Func::Evaluate(const T& x) const {
+	// значения запоминаются, потому что производные разделяют подфункции и 
+	// обход записи вместо различных функций был бы экспоненциальным; 
+	// листья вычисляются на месте и не запоминаются
+	struct Frame {
+		const Func* f;
+		int arity;
+		int next;
+	};
+	thread_local Values<T> values;
+	thread_local std::vector<Frame> frames;
+	thread_local std::vector<T> operands;
+	values.Reset();
+	frames.assign(1, { this, Arity(), 0 });
+	operands.clear();
+	while (!frames.empty()) {
+		Frame& frame = frames.back();
+		if (frame.next < frame.arity) {
+			const Func* arg = frame.f->Arg(frame.next++);
+			int arity = arg->Arity();
+			if (arity == 0) operands.push_back(arg->Apply(x, nullptr));
+			else if (const T* value = values.Find(arg)) operands.push_back(*value);
+			else frames.push_back({ arg, arity, 0 });
+			continue;
+		}
+		// значения аргументов лежат на вершине стека по порядку
+		T value = frame.f->Apply(x, operands.data() + operands.size() - frame.arity);
+		operands.resize(operands.size() - frame.arity);
+		operands.push_back(value);
+		values.Insert(frame.f, value);
+		frames.pop_back();
+	}
+	return operands.back();
+}
+
+double Func::Eval(double x) const {
+	return Evaluate(x);
+}
+
+Dual Func::Eval(const Dual& x) const {
+	return Evaluate(x);
+}
+
+Jet Func::Eval(const Jet& x) const {
+	return Evaluate(x);
+}
+
+std::string Func::repr() const {
+	Printer printer;
+	return printer.Run(this);
+}
+
+// PRINTER
+
+void Printer::Arg(const Func* f, bool brackets) {
+	if (names && names->count(f)) brackets = false;
+	if (brackets) Text("(");
+	pieces.push_back({ f, {}, 0.0f });
+	if (brackets) Text(")");
+}
+
+std::string Printer::Run(const Func* f) {
+	std::string out;
+	Write(f, out, nullptr);
+	return out;
+}
+
+void Printer::Run(const Func* f, std::ostream& os) {
+	std::string buffer;
+	buffer.reserve(2 << 16);
+	Write(f, buffer, &os);
+	os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+
+const std::vector<Printer::Piece>& Printer::Parts(const Func* f) {
+	pieces.clear();
+	f->Print(*this);
+	return pieces;
+}
+
+void Printer::Write(const Func* f, std::string& buffer, std::ostream* os) {
+	constexpr size_t chunk = 1 << 16;
+	DERIVATIVE_STATS_ONLY(stats::Timer timer(stats::Phase::PRINT));
+	stack.clear();
+	Parts(f);
+	stack.insert(stack.end(), pieces.rbegin(), pieces.rend());
+	while (!stack.empty()) {
+		Piece piece = stack.back();
+		stack.pop_back();
+		if (piece.f && names) {
+			auto found = names->find(piece.f);
+			if (found != names->end()) {
+				buffer += found->second;
+				continue;
+			}
+		}
+		if (piece.f) {
+			pieces.clear();
+			piece.f->Print(*this);
+			stack.insert(stack.end(), pieces.rbegin(), pieces.rend());
+			continue;
+		}
+		if (piece.text.data()) buffer += piece.text;
+		else {
+			// как std::to_string, без лишних нулей дробной части
+			char str[64];
+			int length = std::snprintf(str, sizeof(str), "%f", piece.value);
+			int s = length - 1;
+			while (str[s] == '0') --s;
+			buffer.append(str, str[s] == '.' ? s : s + 1);
+		}
+		if (os && buffer.size() >= chunk) {
+			os->write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+			buffer.clear();
+		}
+	}
+}
+
+std::ostream& operator<<(std::ostream& os, const Func& f) {
+	Printer printer;
+	printer.Run(&f, os);
+	return os;
+}
+
+// STORE
+
+FuncStore::~FuncStore() {
+	for (Func* f : table)
+		if (f) f->~Func();
+	for (char* block : blocks) delete[] block;
+}
+
+void FuncStore::Clear() {
+	for (Func* f : table)
+		if (f) f->~Func();
+	// большую таблицу проще завести заново, чем очищать после каждой задачи
+	if (table.size() > 4096) table.clear();
+	else std::fill(table.begin(), table.end(), nullptr);
+	count = 0;
+	derivatives.clear();
+	if (!blocks.empty()) {
+		char* kept = blocks.back();
+		for (size_t i = 0; i + 1 < blocks.size(); ++i) delete[] blocks[i];
+		blocks.assign(1, kept);
+		bytes = static_cast<size_t>(limit - kept);
+		cursor = kept;
+	}
+	last = nullptr;
+}
+
+FuncStore& FuncStore::Current() {
+	if (current_store) return *current_store;
+	thread_local FuncStore fallback;
+	return fallback;
+}
+
+void* FuncStore::Allocate(size_t size) {
+	constexpr size_t align = alignof(std::max_align_t);
+	size = (size + align - 1) & ~(align - 1);
+	if (static_cast<size_t>(limit - cursor) < size) {
+		size_t capacity = size > block_size ? size : block_size;
+		if (block_size < (size_t(1) << 20)) block_size *= 2;
+		cursor = new char[capacity];
+		limit = cursor + capacity;
+		blocks.push_back(cursor);
+		bytes += capacity;
+		DERIVATIVE_STATS_ONLY(stats::Local().bytes += capacity);
+	}
+	last = cursor;
+	cursor += size;
+	return last;
+}
+
+Func* FuncStore::Intern(Func* f) {
+	DERIVATIVE_STATS_ONLY(++stats::Local().made[static_cast<size_t>(f->type)]);
+	if (2 * (count + 1) > table.size()) Grow();
+	size_t mask = table.size() - 1;
+	for (size_t i = static_cast<size_t>(f->hash) & mask;; i = (i + 1) & mask) {
+		if (!table[i]) {
+			table[i] = f;
+			++count;
+			DERIVATIVE_STATS_ONLY(++stats::Local().created[static_cast<size_t>(f->type)]);
+			return f;
+		}
+		if (table[i] == f) return f;
+		if (Same(table[i], f)) {
+			f->~Func();
+			if (reinterpret_cast<char*>(f) == last) cursor = last;
+			last = nullptr;
+			return table[i];
+		}
+	}
+}
+
+bool FuncStore::Contains(const Func* f) const noexcept {
+	if (table.empty()) return false;
+	size_t mask = table.size() - 1;
+	for (size_t i = static_cast<size_t>(f->hash) & mask; table[i]; i = (i + 1) & mask)
+		if (table[i] == f) return true;
+	return false;
+}
+
+void FuncStore::Reserve(size_t n) {
+	size_t size = table.size() ? table.size() : 64;
+	while (size < 2 * n) size *= 2;
+	if (size > table.size()) Rehash(size);
+}
+
+void FuncStore::Grow() {
+	Rehash(table.size() ? table.size() * 2 : 64);
+}
+
+void FuncStore::Rehash(size_t size) {
+	std::vector<Func*> old(size, nullptr);
+	old.swap(table);
+	size_t mask = table.size() - 1;
+	for (Func* f : old) {
+		if (!f) continue;
+		size_t i = static_cast<size_t>(f->hash) & mask;
+		while (table[i]) i = (i + 1) & mask;
+		table[i] = f;
+	}
+}
+
+Func* FuncStore::FindDer(const Func* f, const Func* var) const {
+	if (!Contains(f) || !Contains(var)) return nullptr;
+	return Memo(f, var);
+}
+
+void FuncStore::SaveDer(const Func* f, const Func* var, Func* der) {
+	// ключи запоминаются по указателям, поэтому функция другого хранилища 
+	// после его очистки совпала бы с чужой функцией по адресу
+	if (!Contains(f) || !Contains(var) || !Contains(der)) throw std::runtime_error("der: function is not from this store");
+	Memoize(f, var, der);
+}
+
+Func* FuncStore::Memo(const Func* f, const Func* var) const {
+	auto table = derivatives.find(var);
+	if (table == derivatives.end()) return nullptr;
+	auto found = table->second.find(f);
+	return found == table->second.end() ? nullptr : found->second;
+}
+
+void FuncStore::Memoize(const Func* f, const Func* var, Func* der) {
+	derivatives[var].emplace(f, der);
+}
+
+bool FuncStore::Same(const Func* a, const Func* b) noexcept {
+	if (a->type != b->type || a->hash != b->hash) return false;
+	if (a->Arg(0) != b->Arg(0) || a->Arg(1) != b->Arg(1)) return false;
+	if (a->type == FuncType::NUM)
+		return static_cast<const Num*>(a)->Value() == static_cast<const Num*>(b)->Value();
+	if (a->type == FuncType::VAR)
+		return static_cast<const Var*>(a)->Name() == static_cast<const Var*>(b)->Name();
+	return true;
+}
+
+FuncStore::Scope::Scope(FuncStore& store) : previous(current_store) {
+	current_store = &store;
+}
+
+FuncStore::Scope::~Scope() {
+	current_store = previous;
+}
 
 // CONSTANT
 
-std::string Num::repr() {
-	std::string str = std::to_string(value);
-	size_t s = str.find_last_not_of('0');
-	if (str[s] == '.') return str.substr(0, s);
-	return str.substr(0, s + 1);
+Num::Num(const float v) : Func(FuncType::NUM), value(v) {
+	order = 0;
+	zero = v == 0.0f;
+	one = v == 1.0f;
+	std::uint32_t bits{ 0 };
+	float normalized = v == 0.0f ? 0.0f : v;
+	std::memcpy(&bits, &normalized, sizeof(bits));
+	hash = Mix(hash, bits);
+}
+
+// VAR
+
+bool SameVariable(const Func* a, const Func* b) noexcept {
+	if (a == b) return a->type == FuncType::X || a->type == FuncType::VAR;
+	if (a->type != b->type) return false;
+	if (a->type == FuncType::X) return true;
+	return a->type == FuncType::VAR && static_cast<const Var*>(a)->Name() == static_cast<const Var*>(b)->Name();
+}
+
+Var::Var(std::string_view name) : Func(FuncType::VAR), name(name) {
+	order = 0;
+	hash = Mix(hash, std::hash<std::string_view>()(name));
 }
 
 // +
 
-std::string Sum::repr() {
-	std::string arg1_repr(arg1->repr()), arg2_repr(arg2->repr());
-	if (arg1_repr == arg2_repr && arg2_repr == "0") return "0";
-	if (arg1_repr == "0") return arg2_repr;
-	if (arg2_repr == "0") return arg1_repr;
-	return arg1_repr + " + " + arg2_repr;
+Sum::Sum(Func* f1, Func* f2) : Func(FuncType::SUM, f1, f2), arg1(f1), arg2(f2) {
+	order = (f1->zero || f2->zero ? 0 : 2);
+	zero = f1->zero && f2->zero;
+	one = (f1->zero && f2->one) || (f2->zero && f1->one);
+}
+
+void Sum::Print(Printer& out) const {
+	if (zero) return out.Text("0");
+	if (arg1->zero) return out.Arg(arg2);
+	if (arg2->zero) return out.Arg(arg1);
+	out.Arg(arg1);
+	out.Text(" + ");
+	out.Arg(arg2);
 }
 
 // -
 
-std::string Sub::repr() {
-	std::string arg1_repr(arg1->repr()), arg2_repr(arg2->repr());
-	if (arg1_repr == arg2_repr && arg2_repr == "0") return "0";
-	if (arg1_repr == "0") return "-" + arg2_repr;
-	if (arg2_repr == "0") return arg1_repr;
-	std::string s2 = arg2->order < 5 && arg2->order > 0 ? "(" + arg2_repr + ")" : arg2_repr;
-	return arg1_repr + " - " + s2;
+Sub::Sub(Func* f1, Func* f2) : Func(FuncType::SUB, f1, f2), arg1(f1), arg2(f2) {
+	order = (f1->zero ? 1 : 2);
+	zero = f1->zero && f2->zero;
+	one = f2->zero && f1->one;
+}
+
+void Sub::Print(Printer& out) const {
+	if (zero) return out.Text("0");
+	if (arg1->zero) {
+		out.Text("-");
+		return out.Arg(arg2);
+	}
+	if (arg2->zero) return out.Arg(arg1);
+	out.Arg(arg1);
+	out.Text(" - ");
+	out.Arg(arg2, arg2->order < 5 && arg2->order > 0);
 }
 
 // *
 
-Mult::Mult(Func* f1, Func* f2) : arg1(f1), arg2(f2) {
-	std::string arg1_repr(arg1->repr()), arg2_repr(arg2->repr());
-	if (arg1_repr == "0" || arg2_repr == "0") order = 0;
-	else if (arg1_repr == "1") order = arg2->order;
-	else if (arg2_repr == "1") order = arg1->order;
+Mult::Mult(Func* f1, Func* f2) : Func(FuncType::MULT, f1, f2), arg1(f1), arg2(f2) {
+	if (f1->zero || f2->zero) order = 0;
+	else if (f1->one) order = f2->order;
+	else if (f2->one) order = f1->order;
 	else order = 3;
+	zero = f1->zero || f2->zero;
+	one = f1->one && f2->one;
 }
 
-Func* Mult::Der() {
-	return new Sum(
-		new Mult(arg1->Der(), arg2),
-		new Mult(arg1, arg2->Der())
+Func* Mult::Differentiate(const Func* var) {
+	return Make<Sum>(
+		Make<Mult>(arg1->Der(var), arg2),
+		Make<Mult>(arg1, arg2->Der(var))
 	);
 }
 
-std::string Mult::repr() {
-	std::string arg1_repr(arg1->repr()), arg2_repr(arg2->repr());
-	if (arg1_repr == "0" || arg2_repr == "0") return "0";
-	if (arg1_repr == "1") return arg2_repr;
-	if (arg2_repr == "1") return arg1_repr;
-	std::string s1 = arg1->order < 3 && arg1->order > 0 ? "(" + arg1_repr + ")" : arg1_repr;
-	std::string s2 = arg2->order < 4 && arg2->order > 0 ? "(" + arg2_repr + ")" : arg2_repr;
-	return s1 + " * " + s2;
+void Mult::Print(Printer& out) const {
+	if (zero) return out.Text("0");
+	if (arg1->one) return out.Arg(arg2);
+	if (arg2->one) return out.Arg(arg1);
+	out.Arg(arg1, arg1->order < 3 && arg1->order > 0);
+	out.Text(" * ");
+	out.Arg(arg2, arg2->order < 4 && arg2->order > 0);
 }
 
 // /
 
-std::string Division::repr() {
-	std::string arg1_repr(arg1->repr());
-	if (arg1_repr == "0") return "0";
-	std::string arg2_repr(arg2->repr());
-	if (arg2_repr == "1") return arg1_repr;
-	std::string s1 = arg1->order < 3 && arg1->order > 1 ? "(" + arg1_repr + ")" : arg1_repr;
-	std::string s2 = arg2->order < 4 && arg2->order > 0 ? "(" + arg2_repr + ")" : arg2_repr;
-	return s1 + " / " + s2;
-}
-
-Func* Division::Der() {
-	return new Division(
-		new Sub(
-			new Mult(arg1->Der(), arg2),
-			new Mult(arg1, arg2->Der())
+Division::Division(Func* f1, Func* f2) : Func(FuncType::DIVISION, f1, f2), arg1(f1), arg2(f2) {
+	order = 3;
+	zero = f1->zero;
+	one = f2->one && f1->one;
+}
+
+void Division::Print(Printer& out) const {
+	if (zero) return out.Text("0");
+	if (arg2->one) return out.Arg(arg1);
+	out.Arg(arg1, arg1->order < 3 && arg1->order > 1);
+	out.Text(" / ");
+	out.Arg(arg2, arg2->order < 4 && arg2->order > 0);
+}
+
+Func* Division::Differentiate(const Func* var) {
+	return Make<Division>(
+		Make<Sub>(
+			Make<Mult>(arg1->Der(var), arg2),
+			Make<Mult>(arg1, arg2->Der(var))
 		),
-		new Pow(arg2, new Num(2))
+		Make<Pow>(arg2, Make<Num>(2))
 	);
 }
 
 // SIN
 
-Func* Sin::Der() {
-	return new Mult(new Cos(arg), arg->Der());
+Func* Sin::Differentiate(const Func* var) {
+	return Make<Mult>(Make<Cos>(arg), arg->Der(var));
 }
 
 // COS
 
-Func* Cos::Der() {
-	return new Sub(new Num(0), new Mult(new Sin(arg), arg->Der()));
+Func* Cos::Differentiate(const Func* var) {
+	return Make<Sub>(Make<Num>(0), Make<Mult>(Make<Sin>(arg), arg->Der(var)));
 }
 
 // TG
 
-Func* Tg::Der() {
-	return new Division(
-		arg->Der(),
-		new Pow(new Cos(arg), new Num(2))
+Func* Tg::Differentiate(const Func* var) {
+	return Make<Division>(
+		arg->Der(var),
+		Make<Pow>(Make<Cos>(arg), Make<Num>(2))
 	);
 }
 
 // CTG
 
-Func* Ctg::Der() {
-	return new Sub(
-		new Num(0),
-		new Division(
-			arg->Der(),
-			new Pow(new Sin(arg), new Num(2))
+Func* Ctg::Differentiate(const Func* var) {
+	return Make<Sub>(
+		Make<Num>(0),
+		Make<Division>(
+			arg->Der(var),
+			Make<Pow>(Make<Sin>(arg), Make<Num>(2))
 		)
 	);
 }
 
 // LN
 
-std::string Ln::repr() {
-	std::string arg_repr(arg->repr());
-	if (arg_repr == "e") return "1";
-	if (arg_repr == "1") return "0";
-	return "ln(" + arg_repr + ")";
+Ln::Ln(Func* f) : Func(FuncType::LN, f), arg(f) {
+	order = 5;
+	zero = f->one;
+	one = f->type == FuncType::E;
+}
+
+void Ln::Print(Printer& out) const {
+	if (one) return out.Text("1");
+	if (zero) return out.Text("0");
+	out.Text("ln(");
+	out.Arg(arg);
+	out.Text(")");
 }
 
 // LG
 
-Func* Lg::Der() {
-	return new Division(
-		arg->Der(),
-		new Mult(arg, new Ln(new Num(10)))
+Lg::Lg(Func* f) : Func(FuncType::LG, f), arg(f) {
+	order = 5;
+	zero = f->one;
+	one = f->type == FuncType::NUM && static_cast<Num*>(f)->Value() == 10.0f;
+}
+
+Func* Lg::Differentiate(const Func* var) {
+	return Make<Division>(
+		arg->Der(var),
+		Make<Mult>(arg, Make<Ln>(Make<Num>(10)))
 	);
 }
 
-std::string Lg::repr() {
-	std::string arg_repr(arg->repr());
-	if (arg_repr == "10") return "1";
-	if (arg_repr == "1") return "0";
-	return "lg(" + arg_repr + ")";
+void Lg::Print(Printer& out) const {
+	if (one) return out.Text("1");
+	if (zero) return out.Text("0");
+	out.Text("lg(");
+	out.Arg(arg);
+	out.Text(")");
 }
 
 // POWER
 
-Func* Pow::Der() {
-	return new Sum(
-		new Mult(
-			new Mult(
-				new Pow(
+Pow::Pow(Func* f1, Func* f2) : Func(FuncType::POW, f1, f2), base(f1), arg(f2) {
+	order = 4;
+	if (f2->one) {
+		zero = f1->zero;
+		one = f1->one;
+	}
+	else if (f2->zero) one = true;
+	else zero = f1->zero;
+}
+
+Func* Pow::Differentiate(const Func* var) {
+	return Make<Sum>(
+		Make<Mult>(
+			Make<Mult>(
+				Make<Pow>(
 					base,
-					new Sub(arg, new Num(1.0f))
+					Make<Sub>(arg, Make<Num>(1.0f))
 				),
 				arg
 			),
-			base->Der()
+			base->Der(var)
 		),
-		new Mult(
-			new Mult(arg->Der(), new Ln(base)),
-			new Pow(base, arg)
+		Make<Mult>(
+			Make<Mult>(arg->Der(var), Make<Ln>(base)),
+			Make<Pow>(base, arg)
 		)
 	);
 }
 
-std::string Pow::repr() {
-	std::string arg_repr(arg->repr());
-	std::string base_repr(base->repr());
-	if (arg_repr == "1") return base_repr;
-	if (arg_repr == "0") return "1";
-	if (base_repr == "0") return "0";
-	std::string s1 = base->order < 4 && base->order > 0 ? "(" + base_repr + ")" : base_repr;
-	std::string s2 = arg->order < 5 && arg->order > 0 ? "(" + arg_repr + ")" : arg_repr;
-	return s1 + " ^ " + s2;
+void Pow::Print(Printer& out) const {
+	if (arg->one) return out.Arg(base);
+	if (one) return out.Text("1");
+	if (zero) return out.Text("0");
+	out.Arg(base, base->order < 4 && base->order > 0);
+	out.Text(" ^ ");
+	out.Arg(arg, arg->order < 5 && arg->order > 0);
 }
 
 // SQRT
 
-Func* Sqrt::Der() {
-	return new Division(
-		arg->Der(),
-		new Mult(new Num(2), new Sqrt(arg))
+Func* Sqrt::Differentiate(const Func* var) {
+	return Make<Division>(
+		arg->Der(var),
+		Make<Mult>(Make<Num>(2), Make<Sqrt>(arg))
 	);
 }
 
-std::string Sqrt::repr() {
-	std::string arg_repr(arg->repr());
-	if (arg_repr == "0") return "0";
-	return "sqrt(" + arg_repr + ")";
+void Sqrt::Print(Printer& out) const {
+	if (zero) return out.Text("0");
+	out.Text("sqrt(");
+	out.Arg(arg);
+	out.Text(")");
 }
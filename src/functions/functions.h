@@ -1,7 +1,41 @@
 ﻿#ifndef FUNCTIONS_FUNCTIONS_H_20221801
 #define FUNCTIONS_FUNCTIONS_H_20221801
 
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
 #include <string>
+#include <string_view>
+#include <new>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <functions/dual.h>
+
+/// Перечисление, содержащее все виды функций
+enum class FuncType {
+	NUM,
+	E,
+	PI,
+	X,
+	SUM,
+	SUB,
+	MULT,
+	DIVISION,
+	SIN,
+	COS,
+	TG,
+	CTG,
+	LN,
+	LG,
+	POW,
+	SQRT,
+	VAR
+};
+
+class Printer;
 
 /*!
 \brief Абстрактный класс, имеющий методы Der(), repr().
@@ -13,8 +47,8 @@
 #include <functions/functions.cpp>
 
 int main(){
-	Func* num(new Num(4));
-	Func* cos(new Cos(num));
+	Func* num(Make<Num>(4));
+	Func* cos(Make<Cos>(num));
 	std::cout << cos->repr() << '\n';
 	std::cout << cos->Der()->repr() << '\n';
 }
@@ -37,19 +71,333 @@ public:
 	/*!
 	Метод вычисляет производную для текущего экземпляра
 
-	\return Func* производная функции
+	Производная запоминается в FuncStore::Current(), поэтому подфункция, общая 
+	для многих функций, дифференцируется один раз. Аргументы дифференцируются 
+	обходом с явным стеком раньше самой функции, так что глубина рекурсии не 
+	зависит от глубины функции
+	\return Func* производная функции по x
+	\throw std::runtime_error - если функция не из FuncStore::Current()
 	*/
-	virtual Func* Der() = 0;
+	Func* Der();
+	/*!
+	Метод вычисляет частную производную по переменной
+
+	Производные по разным переменным запоминаются отдельно
+	\param[in] var переменная: X или Var из FuncStore::Current()
+	\return Func* частная производная функции
+	\throw std::runtime_error - если функция или переменная не из FuncStore::Current()
+	*/
+	Func* Der(const Func* var);
 	/*!
 	Метод получает строковую репрезентацию функции
 
+	Печать идет через Printer с явным стеком, поэтому работает для функций любой глубины
 	\return string строковая репрезентация
 	*/
-	virtual std::string repr() = 0;
+	std::string repr() const;
+	/*!
+	Метод сообщает printer запись функции: текст и аргументы по порядку
+
+	Аргументы не печатаются рекурсивно, их раскрывает сам printer
+	\param[in] out printer
+	*/
+	virtual void Print(Printer& out) const = 0;
+	/*!
+	Метод вычисляет значение функции в точке
+
+	Вне области определения результат следует IEEE 754: \f$ln, lg, sqrt\f$ 
+	отрицательного числа дают NaN, \f$ln(0), lg(0)\f$ дают -inf, 
+	\f$ctg\f$ в нулях синуса дает \f$\pm\f$inf
+	Вместо x подставляется значение, остальные переменные (Var) дают NaN; функции 
+	нескольких переменных вычисляет bytecode::Program
+	Каждая различная подфункция вычисляется один раз обходом с явным стеком, поэтому 
+	время линейно по числу функций хранилища, от которых зависит функция, даже когда 
+	запись производной экспоненциально длиннее, а глубина рекурсии постоянна
+	\param[in] x значение переменной
+	\return double значение функции
+	*/
+	double Eval(double x) const;
+	/*!
+	Метод вычисляет значение и первую производную функции в точке за один проход
+
+	Правила дифференцирования те же, что в Der(), но дерево производной не строится. 
+	Обход тот же, что в Eval(double): каждая подфункция вычисляется один раз
+	\param[in] x Dual::Variable(x)
+	\return Dual значение и производная
+	*/
+	Dual Eval(const Dual& x) const;
+	/*!
+	Метод вычисляет коэффициенты Тейлора функции в точке до порядка x.Order()
+
+	Обход тот же, что в Eval(double): каждая подфункция вычисляется один раз
+	\param[in] x Jet::Variable(x, n)
+	\return Jet ряд Тейлора функции
+	*/
+	Jet Eval(const Jet& x) const;
+	/*!
+	Метод возвращает количество аргументов функции
+
+	\return int 0, 1 или 2
+	*/
+	virtual int Arity() const noexcept { return 0; }
+	/*!
+	Метод возвращает аргумент функции
+
+	\param[in] i номер аргумента
+	\return Func* аргумент либо nullptr, если аргумента с таким номером нет
+	*/
+	virtual Func* Arg(int i) const noexcept { return nullptr; }
 	/// Приоритет операции
 	int order{ 0 };
+	/// Функция записывается как "0"
+	bool zero{ false };
+	/// Функция записывается как "1"
+	bool one{ false };
+	/// Функция не зависит ни от одной переменной
+	bool constant{ true };
+	/// Тип функции
+	FuncType type{ FuncType::NUM };
+	/// Структурный хэш: зависит только от типа, значений и хэшей аргументов
+	std::uint64_t hash{ 0 };
+protected:
+	/*!
+	Метод строит производную, вызывая Der(var) аргументов
+
+	\param[in] var переменная дифференцирования
+	\return Func* производная функции
+	*/
+	virtual Func* Differentiate(const Func* var) = 0;
+	/*!
+	Метод вычисляет значение функции по уже вычисленным значениям аргументов
+
+	\param[in] x значение переменной
+	\param[in] args значения аргументов по порядку Arg()
+	\return double значение функции
+	*/
+	virtual double Apply(double x, const double* args) const = 0;
+	/// То же для Eval(const Dual&)
+	virtual Dual Apply(const Dual& x, const Dual* args) const = 0;
+	/// То же для Eval(const Jet&)
+	virtual Jet Apply(const Jet& x, const Jet* args) const = 0;
+	/*!
+	\brief Конструктор, вычисляющий структурный хэш по типу и аргументам
+	\param[in] t тип функции
+	\param[in] f1, f2 аргументы функции
+	*/
+	Func(FuncType t, const Func* f1 = nullptr, const Func* f2 = nullptr);
+private:
+	/// Вычисление для всех Eval() без рекурсии, по разу для каждой подфункции
+	template <class T>
+	T Evaluate(const T& x) const;
+};
+
+/*!
+\brief Класс, печатающий функцию без рекурсии
+
+Func::Print() сообщает части записи функции по порядку, а Printer кладет их на 
+явный стек и раскрывает аргументы по одному, поэтому глубина рекурсии постоянна, 
+а время печати линейно по длине результата. При печати в поток запись уходит 
+блоками по 64 КиБ и целиком в памяти не собирается.
+
+Пример
+\code
+std::ofstream file("derivative.txt");
+file << *f->Der(); // то же, что Printer().Run(f->Der(), file)
+\endcode
+*/
+class Printer {
+public:
+	/// Часть записи: аргумент f, текст или число в записи Num
+	struct Piece {
+		const Func* f;
+		std::string_view text;
+		float value;
+	};
+	/*!
+	\brief Метод добавляет текст
+	\param[in] text текст, живущий до конца печати (обычно строковый литерал)
+	*/
+	void Text(std::string_view text) { pieces.push_back({ nullptr, text, 0.0f }); }
+	/// Метод добавляет число в записи Num
+	void Number(float value) { pieces.push_back({ nullptr, {}, value }); }
+	/*!
+	\brief Метод добавляет аргумент, при необходимости в скобках
+	\param[in] f аргумент
+	\param[in] brackets заключить аргумент в скобки
+	*/
+	void Arg(const Func* f, bool brackets = false);
+	/*!
+	\brief Метод печатает функцию
+	\param[in] f функция
+	\return std::string запись функции
+	*/
+	std::string Run(const Func* f);
+	/*!
+	\brief Метод печатает функцию в поток
+	\param[in] f функция
+	\param[out] os поток
+	*/
+	void Run(const Func* f, std::ostream& os);
+	/*!
+	\brief Метод получает запись функции без раскрытия аргументов
+	\param[in] f функция
+	\return части записи, действительные до следующего вызова методов Printer
+	*/
+	const std::vector<Piece>& Parts(const Func* f);
+	/*!
+	\brief Метод задает имена, которые печатаются вместо подфункций
+	
+	Подфункция с именем печатается именем и без скобок, сама печатаемая функция не заменяется
+	\param[in] names имена или nullptr; таблица должна жить до конца печати
+	*/
+	void Names(const std::unordered_map<const Func*, std::string>* names) { this->names = names; }
+private:
+	void Write(const Func* f, std::string& buffer, std::ostream* os);
+	std::vector<Piece> pieces;
+	const std::unordered_map<const Func*, std::string>* names{ nullptr };
+	std::vector<Piece> stack;
+};
+
+/// Оператор вывода функции в поток через Printer
+std::ostream& operator<<(std::ostream& os, const Func& f);
+
+/*!
+\brief Хранилище функций, в котором структурно одинаковые функции существуют в одном экземпляре
+
+Функции, созданные через Make(), размещаются в арене текущего для потока хранилища. 
+Если в хранилище уже есть функция того же типа с тем же значением и теми же 
+(по указателю) аргументами, возвращается она, а новая сразу освобождается. Поскольку 
+аргументы сами берутся из хранилища, равенство функций сводится к сравнению указателей.
+
+Хранилище владеет своими функциями: вся память арены освобождается одним 
+действием в деструкторе, поэтому хранилище удобно заводить на время одного 
+сеанса разбора и дифференцирования.
+
+Пример создания и использования
+\code
+{
+	FuncStore store;
+	FuncStore::Scope scope(store);
+	simpleparser::Parser parser("sin(x) * x");
+	Func* f = parser.Parse();
+	std::cout << f->Der()->repr() << '\n';
+} // f и f' освобождены
+\endcode
+*/
+class FuncStore {
+public:
+	/// Конструктор по умолчанию
+	FuncStore() = default;
+	FuncStore(const FuncStore&) = delete;
+	FuncStore& operator=(const FuncStore&) = delete;
+	/// Деструктор, освобождающий все функции хранилища
+	~FuncStore();
+	/*!
+	\brief Метод возвращает текущее для потока хранилище
+
+	Если ни одно хранилище не сделано текущим через Scope, используется 
+	хранилище потока, живущее до его завершения
+	\return FuncStore&
+	*/
+	static FuncStore& Current();
+	/*!
+	\brief Метод выделяет память под функцию в арене хранилища
+	\param[in] size размер в байтах
+	\return void* выровненный блок памяти
+	*/
+	void* Allocate(size_t size);
+	/*!
+	\brief Метод добавляет функцию в хранилище
+	\param[in] f функция, размещенная последним вызовом Allocate()
+	\return Func* f либо уже имеющаяся структурно равная функция (тогда f освобождается)
+	*/
+	Func* Intern(Func* f);
+	/*!
+	\brief Метод проверяет, принадлежит ли функция хранилищу
+	\param[in] f функция
+	\return bool f создана в этом хранилище (Make() при нем текущем)
+	*/
+	bool Contains(const Func* f) const noexcept;
+	/*!
+	\brief Метод удаляет все функции хранилища
+
+	Последний блок арены остается и переиспользуется, поэтому хранилище, очищаемое 
+	между независимыми задачами, почти не обращается к системному распределителю
+	*/
+	void Clear();
+	/*!
+	\brief Метод заранее расширяет таблицу хранилища
+
+	Полезен перед созданием известного числа функций (например, при загрузке 
+	сохраненного графа), чтобы таблица не перестраивалась по мере роста
+	\param[in] n ожидаемое число функций в хранилище
+	*/
+	void Reserve(size_t n);
+	/// Количество различных функций в хранилище
+	size_t Size() const noexcept { return count; }
+	/// Объем памяти, занятой блоками арены, в байтах
+	size_t Bytes() const noexcept { return bytes; }
+	/*!
+	\brief Метод ищет запомненную производную функции
+	\param[in] f функция
+	\param[in] var переменная дифференцирования
+	\return Func* производная либо nullptr, в том числе для f или var из другого хранилища
+	*/
+	Func* FindDer(const Func* f, const Func* var) const;
+	/*!
+	\brief Метод запоминает производную функции
+	\param[in] f функция
+	\param[in] var переменная дифференцирования
+	\param[in] der производная f по var из этого хранилища
+	\throw std::runtime_error - если f, var или der не из этого хранилища
+	*/
+	void SaveDer(const Func* f, const Func* var, Func* der);
+	/*!
+	\brief Класс, делающий хранилище текущим для потока на время своей жизни
+	*/
+	class Scope {
+	public:
+		/// Конструктор, делающий store текущим
+		explicit Scope(FuncStore& store);
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+		/// Деструктор, возвращающий предыдущее текущее хранилище
+		~Scope();
+	private:
+		FuncStore* previous;
+	};
+private:
+	friend class Func;
+	void Grow();
+	void Rehash(size_t size);
+	// FindDer() и SaveDer() без проверки принадлежности: Func::Der() проверяет 
+	// функцию и переменную один раз, а их аргументы и производные из этого хранилища
+	Func* Memo(const Func* f, const Func* var) const;
+	void Memoize(const Func* f, const Func* var, Func* der);
+	static bool Same(const Func* a, const Func* b) noexcept;
+	// открытая адресация с линейным пробированием, размер - степень двойки
+	std::vector<Func*> table;
+	size_t count{ 0 };
+	std::vector<char*> blocks;
+	char* cursor{ nullptr };
+	char* limit{ nullptr };
+	char* last{ nullptr };
+	size_t block_size{ 4096 };
+	size_t bytes{ 0 };
+	// производные по каждой переменной
+	std::unordered_map<const Func*, std::unordered_map<const Func*, Func*>> derivatives;
 };
 
+/*!
+\brief Функция создает функцию типа T в текущем хранилище
+\return Func* единственный экземпляр структурно равных функций
+*/
+template <class T, class... Args>
+Func* Make(Args&&... args) {
+	FuncStore& store = FuncStore::Current();
+	return store.Intern(new (store.Allocate(sizeof(T))) T(std::forward<Args>(args)...));
+}
+
 // CONSTANT
 
 /*!
@@ -57,12 +405,17 @@ public:
 */
 class Num : public Func {
 public:
-	Num(const float v) : value(v) { order = 0; }
+	Num(const float v);
 	/*!
 	\f$Num' = 0\f$
 	*/
-	Func* Der() override { return new Num(0); }
-	std::string repr() override;
+	Func* Differentiate(const Func* var) override { return Make<Num>(0); }
+	void Print(Printer& out) const override { out.Number(value); }
+	double Apply(double x, const double* args) const override { return value; }
+	Dual Apply(const Dual& x, const Dual* args) const override { return { value, 0.0 }; }
+	Jet Apply(const Jet& x, const Jet* args) const override { return Jet(value, x.Order()); }
+	/// Значение числа
+	float Value() const noexcept { return value; }
 private:
 	float value{ 0.0f };
 };
@@ -72,12 +425,15 @@ private:
 */
 class E : public Func {
 public:
-	E() { order = 0; }
+	E() : Func(FuncType::E) { order = 0; }
 	/*!
 	\f$E' = 0\f$
 	*/
-	Func* Der() override { return new Num(0); }
-	std::string repr() override { return "e"; }
+	Func* Differentiate(const Func* var) override { return Make<Num>(0); }
+	void Print(Printer& out) const override { out.Text("e"); }
+	double Apply(double x, const double* args) const override { return 2.718281828459045; }
+	Dual Apply(const Dual& x, const Dual* args) const override { return { 2.718281828459045, 0.0 }; }
+	Jet Apply(const Jet& x, const Jet* args) const override { return Jet(2.718281828459045, x.Order()); }
 };
 
 /*!
@@ -85,27 +441,70 @@ public:
 */
 class PI : public Func {
 public:
-	PI() { order = 0; }
+	PI() : Func(FuncType::PI) { order = 0; }
 	/*!
 	\f$Pi' = 0\f$
 	*/
-	Func* Der() override { return new Num(0); }
-	std::string repr() override { return "pi"; }
+	Func* Differentiate(const Func* var) override { return Make<Num>(0); }
+	void Print(Printer& out) const override { out.Text("pi"); }
+	double Apply(double x, const double* args) const override { return 3.141592653589793; }
+	Dual Apply(const Dual& x, const Dual* args) const override { return { 3.141592653589793, 0.0 }; }
+	Jet Apply(const Jet& x, const Jet* args) const override { return Jet(3.141592653589793, x.Order()); }
 };
 
 // X
 
 /*!
-\brief Класс наследующийся от класса Func. Является независимой переменной
+\brief Класс наследующийся от класса Func. Является независимой переменной x
 */
 class X : public Func {
 public:
-	X() { order = 0; }
+	X() : Func(FuncType::X) { order = 0; }
 	/*!
-	\f$X' = 1\f$
+	\f$X' = 1\f$, по другой переменной 0
 	*/
-	Func* Der() override { return new Num(1); }
-	std::string repr() override { return "x"; }
+	Func* Differentiate(const Func* var) override { return Make<Num>(var->type == FuncType::X ? 1.0f : 0.0f); }
+	void Print(Printer& out) const override { out.Text("x"); }
+	double Apply(double x, const double* args) const override { return x; }
+	Dual Apply(const Dual& x, const Dual* args) const override { return x; }
+	Jet Apply(const Jet& x, const Jet* args) const override { return x; }
+};
+
+/*!
+\brief Функция сравнивает переменные по типу и имени, а не по указателю
+
+Так x из одного хранилища - та же переменная, что x из другого: bytecode::Program 
+сопоставляет листья функции из другого хранилища со своими переменными
+\param[in] a, b функции
+\return bool обе - X либо обе - Var с одинаковым именем
+*/
+bool SameVariable(const Func* a, const Func* b) noexcept;
+
+/*!
+\brief Класс наследующийся от класса Func. Является именованной переменной
+
+Переменные с одинаковым именем - одна функция хранилища. Парсер создает 
+переменную x как X, поэтому Der() - производная по ней
+*/
+class Var : public Func {
+public:
+	/*!
+	\brief Конструктор класса
+	\param[in] name имя переменной
+	*/
+	explicit Var(std::string_view name);
+	/*!
+	\f$\partial v / \partial v = 1\f$, по другой переменной 0
+	*/
+	Func* Differentiate(const Func* var) override { return Make<Num>(SameVariable(var, this) ? 1.0f : 0.0f); }
+	void Print(Printer& out) const override { out.Text(name); }
+	double Apply(double x, const double* args) const override { return std::nan(""); }
+	Dual Apply(const Dual& x, const Dual* args) const override { return { std::nan(""), 0.0 }; }
+	Jet Apply(const Jet& x, const Jet* args) const override { return Jet(std::nan(""), x.Order()); }
+	/// Имя переменной
+	const std::string& Name() const noexcept { return name; }
+private:
+	std::string name;
 };
 
 // BINARY OPERATORS
@@ -115,12 +514,17 @@ public:
 */
 class Sum : public Func {
 public:
-	Sum(Func* f1, Func* f2) : arg1(f1), arg2(f2) { order = (f1->repr() == "0" || f2->repr() == "0" ? 0 : 2); }
+	Sum(Func* f1, Func* f2);
 	/*!
 	\f$(a + b)' = a' + b'\f$
 	*/
-	Func* Der() override { return new Sum(arg1->Der(), arg2->Der()); }
-	std::string repr() override;
+	Func* Differentiate(const Func* var) override { return Make<Sum>(arg1->Der(var), arg2->Der(var)); }
+	void Print(Printer& out) const override;
+	double Apply(double x, const double* args) const override { return args[0] + args[1]; }
+	Dual Apply(const Dual& x, const Dual* args) const override { return args[0] + args[1]; }
+	Jet Apply(const Jet& x, const Jet* args) const override { return args[0] + args[1]; }
+	int Arity() const noexcept override { return 2; }
+	Func* Arg(int i) const noexcept override { return i == 0 ? arg1 : i == 1 ? arg2 : nullptr; }
 private:
 	Func* arg1, * arg2;
 };
@@ -130,12 +534,17 @@ private:
 */
 class Sub : public Func {
 public:
-	Sub(Func* f1, Func* f2) : arg1(f1), arg2(f2) { order = (f1->repr() == "0" ? 1 : 2); }
+	Sub(Func* f1, Func* f2);
 	/*!
 	\f$(a - b)' = a' - b'\f$
 	*/
-	Func* Der() override { return new Sub(arg1->Der(), arg2->Der()); }
-	std::string repr() override;
+	Func* Differentiate(const Func* var) override { return Make<Sub>(arg1->Der(var), arg2->Der(var)); }
+	void Print(Printer& out) const override;
+	double Apply(double x, const double* args) const override { return args[0] - args[1]; }
+	Dual Apply(const Dual& x, const Dual* args) const override { return args[0] - args[1]; }
+	Jet Apply(const Jet& x, const Jet* args) const override { return args[0] - args[1]; }
+	int Arity() const noexcept override { return 2; }
+	Func* Arg(int i) const noexcept override { return i == 0 ? arg1 : i == 1 ? arg2 : nullptr; }
 private:
 	Func* arg1, * arg2;
 };
@@ -149,8 +558,13 @@ public:
 	/*!
 	\f$(ab)' = a'b + ab'\f$
 	*/
-	Func* Der() override;
-	std::string repr() override;
+	Func* Differentiate(const Func* var) override;
+	void Print(Printer& out) const override;
+	double Apply(double x, const double* args) const override { return args[0] * args[1]; }
+	Dual Apply(const Dual& x, const Dual* args) const override { return args[0] * args[1]; }
+	Jet Apply(const Jet& x, const Jet* args) const override { return args[0] * args[1]; }
+	int Arity() const noexcept override { return 2; }
+	Func* Arg(int i) const noexcept override { return i == 0 ? arg1 : i == 1 ? arg2 : nullptr; }
 private:
 	Func* arg1, * arg2;
 };
@@ -160,12 +574,17 @@ private:
 */
 class Division : public Func {
 public:
-	Division(Func* f1, Func* f2) : arg1(f1), arg2(f2) { order = 3; }
+	Division(Func* f1, Func* f2);
 	/*!
 	\f$(a/b)' = (a'b - ab') / b^2\f$
 	*/
-	Func* Der() override;
-	std::string repr() override;
+	Func* Differentiate(const Func* var) override;
+	void Print(Printer& out) const override;
+	double Apply(double x, const double* args) const override { return args[0] / args[1]; }
+	Dual Apply(const Dual& x, const Dual* args) const override { return args[0] / args[1]; }
+	Jet Apply(const Jet& x, const Jet* args) const override { return args[0] / args[1]; }
+	int Arity() const noexcept override { return 2; }
+	Func* Arg(int i) const noexcept override { return i == 0 ? arg1 : i == 1 ? arg2 : nullptr; }
 private:
 	Func* arg1, * arg2;
 };
@@ -177,12 +596,17 @@ private:
 */
 class Sin : public Func {
 public:
-	Sin(Func* f) : arg(f) { order = 5; }
-	Func* Der() override;
+	Sin(Func* f) : Func(FuncType::SIN, f), arg(f) { order = 5; }
+	Func* Differentiate(const Func* var) override;
 	/*!
 	\f$sin(a)' = cos(a)a'\f$
 	*/
-	std::string repr() override { return "sin(" + arg->repr() + ")"; }
+	void Print(Printer& out) const override { out.Text("sin("); out.Arg(arg); out.Text(")"); }
+	double Apply(double x, const double* args) const override { return std::sin(args[0]); }
+	Dual Apply(const Dual& x, const Dual* args) const override { return sin(args[0]); }
+	Jet Apply(const Jet& x, const Jet* args) const override { return sin(args[0]); }
+	int Arity() const noexcept override { return 1; }
+	Func* Arg(int i) const noexcept override { return i == 0 ? arg : nullptr; }
 private:
 	Func* arg;
 };
@@ -192,12 +616,17 @@ private:
 */
 class Cos : public Func {
 public:
-	Cos(Func* f) : arg(f) { order = 5; }
+	Cos(Func* f) : Func(FuncType::COS, f), arg(f) { order = 5; }
 	/*!
 	\f$cos(a)' = -sin(a)a'\f$
 	*/
-	Func* Der() override;
-	std::string repr() override { return "cos(" + arg->repr() + ")"; }
+	Func* Differentiate(const Func* var) override;
+	void Print(Printer& out) const override { out.Text("cos("); out.Arg(arg); out.Text(")"); }
+	double Apply(double x, const double* args) const override { return std::cos(args[0]); }
+	Dual Apply(const Dual& x, const Dual* args) const override { return cos(args[0]); }
+	Jet Apply(const Jet& x, const Jet* args) const override { return cos(args[0]); }
+	int Arity() const noexcept override { return 1; }
+	Func* Arg(int i) const noexcept override { return i == 0 ? arg : nullptr; }
 private:
 	Func* arg;
 };
@@ -207,12 +636,17 @@ private:
 */
 class Tg : public Func {
 public:
-	Tg(Func* f) : arg(f) { order = 5; }
+	Tg(Func* f) : Func(FuncType::TG, f), arg(f) { order = 5; }
 	/*!
 	\f$tg(a)' = a'/cos^2(a)\f$
 	*/
-	Func* Der() override;
-	std::string repr() override { return "tg(" + arg->repr() + ")"; }
+	Func* Differentiate(const Func* var) override;
+	void Print(Printer& out) const override { out.Text("tg("); out.Arg(arg); out.Text(")"); }
+	double Apply(double x, const double* args) const override { return std::tan(args[0]); }
+	Dual Apply(const Dual& x, const Dual* args) const override { return tan(args[0]); }
+	Jet Apply(const Jet& x, const Jet* args) const override { return tan(args[0]); }
+	int Arity() const noexcept override { return 1; }
+	Func* Arg(int i) const noexcept override { return i == 0 ? arg : nullptr; }
 private:
 	Func* arg;
 };
@@ -222,12 +656,17 @@ private:
 */
 class Ctg : public Func {
 public:
-	Ctg(Func* f) : arg(f) { order = 5; }
+	Ctg(Func* f) : Func(FuncType::CTG, f), arg(f) { order = 5; }
 	/*!
 	\f$ctg(a)' = a'/sin^2(a)\f$
 	*/
-	Func* Der() override;
-	std::string repr() override { return "ctg(" + arg->repr() + ")"; }
+	Func* Differentiate(const Func* var) override;
+	void Print(Printer& out) const override { out.Text("ctg("); out.Arg(arg); out.Text(")"); }
+	double Apply(double x, const double* args) const override { return std::cos(args[0]) / std::sin(args[0]); }
+	Dual Apply(const Dual& x, const Dual* args) const override { return cos(args[0]) / sin(args[0]); }
+	Jet Apply(const Jet& x, const Jet* args) const override { return cos(args[0]) / sin(args[0]); }
+	int Arity() const noexcept override { return 1; }
+	Func* Arg(int i) const noexcept override { return i == 0 ? arg : nullptr; }
 private:
 	Func* arg;
 };
@@ -240,12 +679,17 @@ private:
 */
 class Ln : public Func {
 public:
-	Ln(Func* f) : arg(f) { order = 5; }
+	Ln(Func* f);
 	/*!
 	\f$ln(a)' = a'/a\f$
 	*/
-	Func* Der() override { return new Division(arg->Der(), arg); }
-	std::string repr() override;
+	Func* Differentiate(const Func* var) override { return Make<Division>(arg->Der(var), arg); }
+	void Print(Printer& out) const override;
+	double Apply(double x, const double* args) const override { return std::log(args[0]); }
+	Dual Apply(const Dual& x, const Dual* args) const override { return log(args[0]); }
+	Jet Apply(const Jet& x, const Jet* args) const override { return log(args[0]); }
+	int Arity() const noexcept override { return 1; }
+	Func* Arg(int i) const noexcept override { return i == 0 ? arg : nullptr; }
 private:
 	Func* arg;
 };
@@ -255,12 +699,17 @@ private:
 */
 class Lg : public Func {
 public:
-	Lg(Func* f) : arg(f) { order = 5; }
+	Lg(Func* f);
 	/*!
 	\f$lg(a)' = a'/aln10\f$
 	*/
-	Func* Der() override;
-	std::string repr() override;
+	Func* Differentiate(const Func* var) override;
+	void Print(Printer& out) const override;
+	double Apply(double x, const double* args) const override { return std::log10(args[0]); }
+	Dual Apply(const Dual& x, const Dual* args) const override { return log10(args[0]); }
+	Jet Apply(const Jet& x, const Jet* args) const override { return log10(args[0]); }
+	int Arity() const noexcept override { return 1; }
+	Func* Arg(int i) const noexcept override { return i == 0 ? arg : nullptr; }
 private:
 	Func* arg;
 };
@@ -272,12 +721,17 @@ private:
 */
 class Pow : public Func {
 public:
-	Pow(Func* f1, Func* f2) : base(f1), arg(f2) { order = 4; }
+	Pow(Func* f1, Func* f2);
 	/*!
 	\f$(a^b)' = ba^{b-1}a'+b'a^blna\f$
 	*/
-	Func* Der() override;
-	std::string repr() override;
+	Func* Differentiate(const Func* var) override;
+	void Print(Printer& out) const override;
+	double Apply(double x, const double* args) const override { return std::pow(args[0], args[1]); }
+	Dual Apply(const Dual& x, const Dual* args) const override { return pow(args[0], args[1]); }
+	Jet Apply(const Jet& x, const Jet* args) const override { return pow(args[0], args[1]); }
+	int Arity() const noexcept override { return 2; }
+	Func* Arg(int i) const noexcept override { return i == 0 ? base : i == 1 ? arg : nullptr; }
 private:
 	Func* base, * arg;
 };
@@ -287,14 +741,138 @@ private:
 */
 class Sqrt : public Func {
 public:
-	Sqrt(Func* f) : arg(f) { order = 5; }
+	Sqrt(Func* f) : Func(FuncType::SQRT, f), arg(f) { order = 5; zero = f->zero; }
 	/*!
 	\f$sqrt(a)' = a'/2sqrt(a)\f$
 	*/
-	Func* Der() override;
-	std::string repr() override;
+	Func* Differentiate(const Func* var) override;
+	void Print(Printer& out) const override;
+	double Apply(double x, const double* args) const override { return std::sqrt(args[0]); }
+	Dual Apply(const Dual& x, const Dual* args) const override { return sqrt(args[0]); }
+	Jet Apply(const Jet& x, const Jet* args) const override { return sqrt(args[0]); }
+	int Arity() const noexcept override { return 1; }
+	Func* Arg(int i) const noexcept override { return i == 0 ? arg : nullptr; }
 private:
 	Func* arg;
 };
 
+// SIMPLIFICATION
+
+/*!
+\brief Функция упрощает выражение за один проход снизу вверх
+
+Сворачивает числовые константы, убирает тождества (\f$a + 0, a \cdot 1, a^1, a^0, ln(e)\f$ и т.п.), 
+приводит подобные слагаемые и складывает показатели степеней с одинаковым основанием. 
+Операнды сумм и произведений упорядочиваются канонически, поэтому равные выражения 
+после упрощения совпадают по указателю. Общие подвыражения упрощаются один раз.
+
+Тождества проверяются по значениям чисел, а не по записи. Часть правил расширяет 
+область определения: результат определен там, где исходная функция дает NaN или 
+деление на ноль
+- \f$a / a = 1\f$, \f$0 \cdot a = 0\f$, \f$0 / a = 0\f$ и \f$a^0 = 1\f$ при любом a;
+- \f$a^b \cdot a^c = a^{b + c}\f$, например \f$x^{0.5} \cdot x^{0.5} = x\f$ и \f$x \cdot x^{-1} = 1\f$.
+
+Степень степени \f$(a^b)^n = a^{bn}\f$ сворачивается только при целых b и n и 
+область определения не меняет
+\param[in] f функция
+\return Func* упрощенная функция из FuncStore::Current()
+*/
+Func* Simplify(Func* f);
+
+/*!
+\brief Функция вычисляет производную порядка n
+
+Каждая следующая производная берется от упрощенной предыдущей, а производные 
+подфункций запоминаются, поэтому время и память растут с порядком примерно так же, 
+как размер упрощенного результата, а не экспоненциально
+\param[in] f функция
+\param[in] n порядок производной, n >= 0
+\return Func* упрощенная производная из FuncStore::Current()
+*/
+Func* Derivative(Func* f, int n);
+
+// GRADIENT
+
+/*!
+\brief Функция находит переменные функции
+\param[in] f функция
+\return std::vector<Func*> X и Var, от которых зависит f, упорядоченные по имени
+*/
+std::vector<Func*> Variables(Func* f);
+
+/*!
+\brief Функция вычисляет все частные производные функции одним обратным проходом
+
+В отличие от Der(var) для каждой переменной, функция обходит f один раз от корня 
+к листьям, накапливая в каждой подфункции \f$\bar{u} = \partial f / \partial u\f$ 
+(сопряженное значение) и передавая аргументам \f$\bar{u} \cdot \partial u / \partial a\f$. 
+Общие подфункции обрабатываются один раз, поэтому размер всех производных вместе 
+линеен по размеру f при любом числе переменных, а сами производные разделяют 
+общие части (их удобно вычислять одной bytecode::Program или записывать через codegen).
+
+Пример
+\code
+Func* f = simpleparser::Parser("x * y + sin(x * z)").Parse();
+std::vector<Func*> vars = Variables(f); // x, y, z
+std::vector<Func*> grad = Gradient(f, vars);
+\endcode
+\param[in] f функция
+\param[in] vars переменные: X или Var из FuncStore::Current()
+\return std::vector<Func*> частные производные f по vars в том же порядке
+\throw std::runtime_error - если f или переменная не из FuncStore::Current()
+*/
+std::vector<Func*> Gradient(Func* f, const std::vector<Func*>& vars);
+
+/// Разреженная матрица производных
+struct SparseMatrix {
+	/// Элемент матрицы
+	struct Entry {
+		/// Строка
+		size_t row;
+		/// Столбец
+		size_t col;
+		/// Производная
+		Func* f;
+	};
+	/// Количество строк
+	size_t rows{ 0 };
+	/// Количество столбцов
+	size_t cols{ 0 };
+	/// Элементы, не равные нулю по структуре: по строкам, в строке по столбцам
+	std::vector<Entry> entries;
+	/*!
+	\brief Метод ищет элемент матрицы
+	\param[in] row, col строка и столбец
+	\return Func* элемент либо nullptr, если он равен нулю по структуре
+	*/
+	Func* At(size_t row, size_t col) const;
+};
+
+/*!
+\brief Функция вычисляет матрицу Якоби системы функций
+
+Элемент (i, k) строится, только если fs[i] зависит от vars[k]: зависимости 
+подфункций от переменных находятся одним обходом. Производные по переменной 
+берутся через Der(var) и запоминаются в хранилище, поэтому подфункция, общая для 
+нескольких строк, дифференцируется по каждой переменной один раз, а в подфункции, 
+не зависящие от переменной, дифференцирование не спускается
+\param[in] fs функции - строки матрицы
+\param[in] vars переменные - столбцы матрицы
+\return SparseMatrix
+\throw std::runtime_error - если функция или переменная не из FuncStore::Current()
+*/
+SparseMatrix Jacobian(const std::vector<Func*>& fs, const std::vector<Func*>& vars);
+
+/*!
+\brief Функция вычисляет матрицу Гессе функции
+
+Градиент строится одним обратным проходом (Gradient()), затем матрица Якоби 
+градиента с теми же правилами разреженности, что в Jacobian(). Вычисляется 
+только нижний треугольник, симметричный элемент указывает на ту же функцию
+\param[in] f функция
+\param[in] vars переменные
+\return SparseMatrix симметричная матрица vars.size() x vars.size()
+*/
+SparseMatrix Hessian(Func* f, const std::vector<Func*>& vars);
+
 #endif // !FUNCTIONS_FUNCTIONS_H_20221801
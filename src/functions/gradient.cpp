@@ -0,0 +1,228 @@
+﻿#include <functions/functions.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+	std::string_view Name(const Func* f) {
+		return f->type == FuncType::VAR ? std::string_view(static_cast<const Var*>(f)->Name()) : "x";
+	}
+
+	// производные строятся из подфункций и сопряженные значения ищутся по указателям, 
+	// поэтому функции и переменные из другого хранилища отвергаются, как в Der(var)
+	void CheckStore(const std::vector<Func*>& fs) {
+		FuncStore& store = FuncStore::Current();
+		for (Func* f : fs)
+			if (!store.Contains(f)) throw std::runtime_error("gradient: function is not from the current store");
+	}
+
+	// функции, зависящие от переменных: аргументы раньше использующих их функций
+	std::vector<Func*> Order(Func* f) {
+		std::vector<Func*> order;
+		if (f->constant) return order;
+		std::unordered_set<Func*> visited;
+		std::vector<std::pair<Func*, bool>> stack{ { f, false } };
+		while (!stack.empty()) {
+			auto [g, expanded] = stack.back();
+			stack.pop_back();
+			if (expanded) {
+				order.push_back(g);
+				continue;
+			}
+			if (!visited.insert(g).second) continue;
+			stack.push_back({ g, true });
+			for (int i = g->Arity() - 1; i >= 0; --i)
+				if (!g->Arg(i)->constant && !visited.count(g->Arg(i))) stack.push_back({ g->Arg(i), false });
+		}
+		return order;
+	}
+
+	// вклад функции f с сопряженным значением adjoint в сопряженное значение ее аргумента i;
+	// те же формулы, что в Differentiate(), но множитель a' заменен на adjoint
+	Func* Contribution(Func* f, int i, Func* adjoint) {
+		Func* a = f->Arg(0);
+		switch (f->type) {
+		case FuncType::SUM:
+			return adjoint;
+		case FuncType::SUB:
+			return i == 0 ? adjoint : Make<Sub>(Make<Num>(0), adjoint);
+		case FuncType::MULT:
+			return Make<Mult>(adjoint, f->Arg(1 - i));
+		case FuncType::DIVISION:
+			if (i == 0) return Make<Division>(adjoint, f->Arg(1));
+			return Make<Sub>(
+				Make<Num>(0),
+				Make<Division>(Make<Mult>(adjoint, a), Make<Pow>(f->Arg(1), Make<Num>(2)))
+			);
+		case FuncType::POW:
+			if (i == 0) return Make<Mult>(adjoint, Make<Mult>(Make<Pow>(a, Make<Sub>(f->Arg(1), Make<Num>(1.0f))), f->Arg(1)));
+			return Make<Mult>(adjoint, Make<Mult>(Make<Ln>(a), f));
+		case FuncType::SIN:
+			return Make<Mult>(adjoint, Make<Cos>(a));
+		case FuncType::COS:
+			return Make<Sub>(Make<Num>(0), Make<Mult>(adjoint, Make<Sin>(a)));
+		case FuncType::TG:
+			return Make<Division>(adjoint, Make<Pow>(Make<Cos>(a), Make<Num>(2)));
+		case FuncType::CTG:
+			return Make<Sub>(Make<Num>(0), Make<Division>(adjoint, Make<Pow>(Make<Sin>(a), Make<Num>(2))));
+		case FuncType::LN:
+			return Make<Division>(adjoint, a);
+		case FuncType::LG:
+			return Make<Division>(adjoint, Make<Mult>(a, Make<Ln>(Make<Num>(10))));
+		default:
+			return Make<Division>(adjoint, Make<Mult>(Make<Num>(2), Make<Sqrt>(a)));
+		}
+	}
+
+	// переменные, от которых зависят подфункции: номера в vars по возрастанию
+	class Dependencies {
+	public:
+		explicit Dependencies(const std::vector<Func*>& vars);
+		const std::vector<std::uint32_t>& Of(Func* f);
+		bool Has(Func* f, std::uint32_t k) {
+			const std::vector<std::uint32_t>& set = Of(f);
+			return std::binary_search(set.begin(), set.end(), k);
+		}
+	private:
+		const std::vector<Func*>& vars;
+		std::unordered_map<const Func*, std::vector<std::uint32_t>> sets;
+		std::vector<std::uint32_t> none;
+	};
+
+	Dependencies::Dependencies(const std::vector<Func*>& vars) : vars(vars) {}
+
+	const std::vector<std::uint32_t>& Dependencies::Of(Func* f) {
+		if (f->constant) return none;
+		auto found = sets.find(f);
+		if (found != sets.end()) return found->second;
+		std::vector<std::pair<Func*, bool>> stack{ { f, false } };
+		while (!stack.empty()) {
+			auto [g, expanded] = stack.back();
+			if (sets.count(g)) {
+				stack.pop_back();
+				continue;
+			}
+			if (!expanded) {
+				stack.back().second = true;
+				for (int i = g->Arity() - 1; i >= 0; --i)
+					if (!g->Arg(i)->constant && !sets.count(g->Arg(i))) stack.push_back({ g->Arg(i), false });
+				continue;
+			}
+			stack.pop_back();
+			std::vector<std::uint32_t> set;
+			// переменная сравнивается по имени, как при дифференцировании
+			for (size_t k = 0; k < vars.size(); ++k)
+				if (SameVariable(g, vars[k])) {
+					set.push_back(static_cast<std::uint32_t>(k));
+					break;
+				}
+			for (int i = 0; i < g->Arity(); ++i) {
+				const std::vector<std::uint32_t>& arg = Of(g->Arg(i));
+				std::vector<std::uint32_t> merged;
+				std::set_union(set.begin(), set.end(), arg.begin(), arg.end(), std::back_inserter(merged));
+				set.swap(merged);
+			}
+			sets.emplace(g, std::move(set));
+		}
+		return sets.at(f);
+	}
+
+	// производная f по vars[k]: подфункциям, не зависящим от переменной, заранее 
+	// запоминается производная 0, и Der(var) в них не спускается
+	Func* SparseDer(Func* f, std::uint32_t k, Func* var, Dependencies& deps) {
+		FuncStore& store = FuncStore::Current();
+		if (Func* der = store.FindDer(f, var)) return der;
+		std::unordered_set<Func*> visited{ f };
+		std::vector<Func*> stack{ f };
+		while (!stack.empty()) {
+			Func* g = stack.back();
+			stack.pop_back();
+			for (int i = 0; i < g->Arity(); ++i) {
+				Func* arg = g->Arg(i);
+				if (store.FindDer(arg, var) || !visited.insert(arg).second) continue;
+				if (deps.Has(arg, k)) stack.push_back(arg);
+				else store.SaveDer(arg, var, Make<Num>(0));
+			}
+		}
+		return f->Der(var);
+	}
+}
+
+Func* SparseMatrix::At(size_t row, size_t col) const {
+	auto found = std::lower_bound(entries.begin(), entries.end(), std::make_pair(row, col),
+		[](const Entry& e, const std::pair<size_t, size_t>& key) { return std::make_pair(e.row, e.col) < key; });
+	return found != entries.end() && found->row == row && found->col == col ? found->f : nullptr;
+}
+
+std::vector<Func*> Variables(Func* f) {
+	std::vector<Func*> vars;
+	for (Func* g : Order(f))
+		if (g->type == FuncType::X || g->type == FuncType::VAR) vars.push_back(g);
+	std::sort(vars.begin(), vars.end(), [](const Func* a, const Func* b) { return Name(a) < Name(b); });
+	return vars;
+}
+
+std::vector<Func*> Gradient(Func* f, const std::vector<Func*>& vars) {
+	CheckStore({ f });
+	CheckStore(vars);
+	std::vector<Func*> order = Order(f);
+	std::unordered_map<Func*, Func*> adjoints;
+	if (!order.empty()) adjoints.emplace(f, Make<Num>(1));
+	// функция обрабатывается после всех использующих ее, когда ее сопряженное значение накоплено
+	for (auto it = order.rbegin(); it != order.rend(); ++it) {
+		Func* g = *it;
+		auto found = adjoints.find(g);
+		if (found == adjoints.end() || found->second->zero) continue;
+		Func* adjoint = found->second;
+		for (int i = 0; i < g->Arity(); ++i) {
+			Func* arg = g->Arg(i);
+			if (arg->constant) continue;
+			Func* contribution = Contribution(g, i, adjoint);
+			auto [slot, fresh] = adjoints.emplace(arg, contribution);
+			if (!fresh) slot->second = Make<Sum>(slot->second, contribution);
+		}
+	}
+	std::vector<Func*> result;
+	for (Func* var : vars) {
+		auto found = adjoints.find(var);
+		result.push_back(found == adjoints.end() ? Make<Num>(0) : found->second);
+	}
+	return result;
+}
+
+SparseMatrix Jacobian(const std::vector<Func*>& fs, const std::vector<Func*>& vars) {
+	CheckStore(fs);
+	CheckStore(vars);
+	Dependencies deps(vars);
+	SparseMatrix m;
+	m.rows = fs.size();
+	m.cols = vars.size();
+	for (size_t i = 0; i < fs.size(); ++i)
+		for (std::uint32_t k : deps.Of(fs[i]))
+			m.entries.push_back({ i, k, SparseDer(fs[i], k, vars[k], deps) });
+	return m;
+}
+
+SparseMatrix Hessian(Func* f, const std::vector<Func*>& vars) {
+	std::vector<Func*> grad = Gradient(f, vars);
+	Dependencies deps(vars);
+	SparseMatrix m;
+	m.rows = m.cols = vars.size();
+	for (size_t i = 0; i < grad.size(); ++i) {
+		for (std::uint32_t k : deps.Of(grad[i])) {
+			if (k > i) break;
+			Func* h = SparseDer(grad[i], k, vars[k], deps);
+			m.entries.push_back({ i, k, h });
+			if (k != i) m.entries.push_back({ k, i, h });
+		}
+	}
+	std::sort(m.entries.begin(), m.entries.end(), [](const SparseMatrix::Entry& a, const SparseMatrix::Entry& b) {
+		return a.row != b.row ? a.row < b.row : a.col < b.col;
+	});
+	return m;
+}
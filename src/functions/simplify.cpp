@@ -0,0 +1,326 @@
+﻿#include <functions/functions.h>
+#include <functions/stats.h>
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace {
+	bool IsNum(const Func* f) { return f->type == FuncType::NUM; }
+
+	double Value(const Func* f) { return static_cast<const Num*>(f)->Value(); }
+
+	// флаги Func::zero и Func::one описывают запись функции, а не ее значение 
+	// ("0 / 0" записывается как 0), поэтому тождества проверяются по числу
+	bool IsZero(const Func* f) { return IsNum(f) && Value(f) == 0.0; }
+
+	bool IsOne(const Func* f) { return IsNum(f) && Value(f) == 1.0; }
+
+	bool IsNeg(const Func* f) { return f->type == FuncType::SUB && IsZero(f->Arg(0)); }
+
+	// канонический порядок операндов: по типу, затем по структурному хэшу
+	bool Before(const Func* a, const Func* b) {
+		if (a->type != b->type) return a->type < b->type;
+		if (a->hash != b->hash) return a->hash < b->hash;
+		return a < b;
+	}
+
+	Func* Number(double v) { return Make<Num>(static_cast<float>(v)); }
+
+	class Simplifier {
+	public:
+		Func* Run(Func* f);
+	private:
+		struct Term {
+			Func* f;
+			double k;
+		};
+		struct Factor {
+			Func* base;
+			Func* exp;
+		};
+		void Operands(Func* f, std::vector<Func*>& out) const;
+		Func* Build(Func* f);
+		Func* BuildSum(const std::vector<Term>& terms);
+		Func* BuildProduct(const std::vector<Func*>& factors);
+		Func* BuildPow(Func* base, Func* exp);
+		Func* BuildDivision(Func* a, Func* b);
+		Func* BuildUnary(FuncType type, Func* a);
+		Func* Chain(double k, Func* rest);
+		Func* Get(Func* f) const { return memo.find(f)->second; }
+		std::unordered_map<Func*, Func*> memo;
+	};
+
+	// операнды узла: для сумм и произведений - листья всей цепочки одинаковых операций
+	void Simplifier::Operands(Func* f, std::vector<Func*>& out) const {
+		bool sum = f->type == FuncType::SUM || f->type == FuncType::SUB;
+		bool mult = f->type == FuncType::MULT;
+		if (!sum && !mult) {
+			for (int i = 0; i < f->Arity(); ++i) out.push_back(f->Arg(i));
+			return;
+		}
+		std::vector<Func*> stack{ f };
+		while (!stack.empty()) {
+			Func* g = stack.back();
+			stack.pop_back();
+			bool inner = sum ? g->type == FuncType::SUM || g->type == FuncType::SUB : g->type == FuncType::MULT;
+			if (!inner) {
+				out.push_back(g);
+				continue;
+			}
+			stack.push_back(g->Arg(1));
+			stack.push_back(g->Arg(0));
+		}
+	}
+
+	Func* Simplifier::Run(Func* f) {
+		std::vector<std::pair<Func*, bool>> stack{ { f, false } };
+		std::vector<Func*> operands;
+		while (!stack.empty()) {
+			auto [g, expanded] = stack.back();
+			if (memo.count(g)) {
+				stack.pop_back();
+				continue;
+			}
+			if (expanded) {
+				stack.pop_back();
+				memo.emplace(g, Build(g));
+				continue;
+			}
+			stack.back().second = true;
+			operands.clear();
+			Operands(g, operands);
+			for (Func* op : operands)
+				if (!memo.count(op)) stack.push_back({ op, false });
+		}
+		return Get(f);
+	}
+
+	Func* Simplifier::Build(Func* f) {
+		switch (f->type) {
+		case FuncType::SUM:
+		case FuncType::SUB: {
+			std::vector<Term> terms;
+			std::vector<Term> stack{ { f, 1.0 } };
+			while (!stack.empty()) {
+				Term t = stack.back();
+				stack.pop_back();
+				if (t.f->type == FuncType::SUM || t.f->type == FuncType::SUB) {
+					stack.push_back({ t.f->Arg(1), t.f->type == FuncType::SUB ? -t.k : t.k });
+					stack.push_back({ t.f->Arg(0), t.k });
+				}
+				else terms.push_back({ Get(t.f), t.k });
+			}
+			return BuildSum(terms);
+		}
+		case FuncType::MULT: {
+			std::vector<Func*> leaves, factors;
+			Operands(f, leaves);
+			for (Func* leaf : leaves) factors.push_back(Get(leaf));
+			return BuildProduct(factors);
+		}
+		case FuncType::DIVISION:
+			return BuildDivision(Get(f->Arg(0)), Get(f->Arg(1)));
+		case FuncType::POW:
+			return BuildPow(Get(f->Arg(0)), Get(f->Arg(1)));
+		case FuncType::NUM:
+		case FuncType::E:
+		case FuncType::PI:
+		case FuncType::X:
+		case FuncType::VAR:
+			return f;
+		default:
+			return BuildUnary(f->type, Get(f->Arg(0)));
+		}
+	}
+
+	// сумма упрощенных слагаемых с числовыми коэффициентами
+	Func* Simplifier::BuildSum(const std::vector<Term>& terms) {
+		double constant = 0.0;
+		std::vector<Term> merged;
+		std::unordered_map<Func*, size_t> index;
+		std::vector<Term> stack(terms.rbegin(), terms.rend());
+		while (!stack.empty()) {
+			Term t = stack.back();
+			stack.pop_back();
+			Func* g = t.f;
+			if (g->type == FuncType::SUM || g->type == FuncType::SUB) {
+				stack.push_back({ g->Arg(1), g->type == FuncType::SUB ? -t.k : t.k });
+				stack.push_back({ g->Arg(0), t.k });
+				continue;
+			}
+			if (IsNum(g)) {
+				constant += t.k * Value(g);
+				continue;
+			}
+			double k = t.k;
+			Func* rest = g;
+			if (g->type == FuncType::MULT) {
+				std::vector<Func*> factors;
+				Operands(g, factors);
+				if (IsNum(factors.front())) {
+					k *= Value(factors.front());
+					factors.erase(factors.begin());
+					rest = factors.front();
+					for (size_t i = 1; i < factors.size(); ++i) rest = Make<Mult>(rest, factors[i]);
+				}
+			}
+			auto found = index.find(rest);
+			if (found != index.end()) merged[found->second].k += k;
+			else {
+				index.emplace(rest, merged.size());
+				merged.push_back({ rest, k });
+			}
+		}
+		merged.erase(std::remove_if(merged.begin(), merged.end(), [](const Term& t) { return t.k == 0.0; }), merged.end());
+		std::sort(merged.begin(), merged.end(), [](const Term& a, const Term& b) { return Before(a.f, b.f); });
+		// сумма по возможности начинается с положительного слагаемого: "2 - x", а не "-x + 2"
+		auto positive = std::find_if(merged.begin(), merged.end(), [](const Term& t) { return t.k > 0; });
+		if (positive != merged.end()) std::rotate(merged.begin(), positive, positive + 1);
+		Func* result = nullptr;
+		if (positive == merged.end() && constant > 0) {
+			result = Number(constant);
+			constant = 0.0;
+		}
+		for (const Term& t : merged) {
+			Func* term = Chain(std::fabs(t.k), t.f);
+			if (!result) result = t.k < 0 ? Make<Sub>(Make<Num>(0), term) : term;
+			else result = t.k < 0 ? Make<Sub>(result, term) : Make<Sum>(result, term);
+		}
+		if (!result) return Number(constant);
+		if (constant > 0) return Make<Sum>(result, Number(constant));
+		if (constant < 0) return Make<Sub>(result, Number(-constant));
+		return result;
+	}
+
+	// k * rest, где rest - произведение без числового множителя
+	Func* Simplifier::Chain(double k, Func* rest) {
+		if (k == 1.0) return rest;
+		std::vector<Func*> factors;
+		if (rest->type == FuncType::MULT) Operands(rest, factors);
+		else factors.push_back(rest);
+		Func* result = Number(k);
+		for (Func* factor : factors) result = Make<Mult>(result, factor);
+		return result;
+	}
+
+	// произведение упрощенных множителей: степени с одинаковым основанием складываются
+	Func* Simplifier::BuildProduct(const std::vector<Func*>& factors) {
+		double k = 1.0;
+		std::vector<Factor> merged;
+		std::unordered_map<Func*, size_t> index;
+		std::vector<Func*> stack(factors.rbegin(), factors.rend());
+		while (!stack.empty()) {
+			Func* g = stack.back();
+			stack.pop_back();
+			if (g->type == FuncType::MULT) {
+				stack.push_back(g->Arg(1));
+				stack.push_back(g->Arg(0));
+				continue;
+			}
+			if (IsNum(g)) {
+				k *= Value(g);
+				continue;
+			}
+			if (IsNeg(g)) {
+				k = -k;
+				stack.push_back(g->Arg(1));
+				continue;
+			}
+			Factor factor{ g, Make<Num>(1) };
+			if (g->type == FuncType::POW) factor = { g->Arg(0), g->Arg(1) };
+			auto found = index.find(factor.base);
+			if (found != index.end()) {
+				Factor& same = merged[found->second];
+				same.exp = BuildSum({ { same.exp, 1.0 }, { factor.exp, 1.0 } });
+			}
+			else {
+				index.emplace(factor.base, merged.size());
+				merged.push_back(factor);
+			}
+		}
+		if (k == 0.0) return Make<Num>(0);
+		std::vector<Func*> powers;
+		for (const Factor& factor : merged) {
+			Func* power = BuildPow(factor.base, factor.exp);
+			if (IsNum(power)) k *= Value(power);
+			else powers.push_back(power);
+		}
+		if (powers.empty()) return Number(k);
+		std::sort(powers.begin(), powers.end(), Before);
+		Func* result = std::fabs(k) == 1.0 ? nullptr : Number(std::fabs(k));
+		for (Func* power : powers) result = result ? Make<Mult>(result, power) : power;
+		return k < 0 ? Make<Sub>(Make<Num>(0), result) : result;
+	}
+
+	Func* Simplifier::BuildPow(Func* base, Func* exp) {
+		if (IsZero(exp) || IsOne(base)) return Make<Num>(1);
+		if (IsOne(exp)) return base;
+		if (IsNum(exp)) {
+			double e = Value(exp);
+			if (IsZero(base) && e > 0) return Make<Num>(0);
+			if (IsNum(base)) {
+				double r = std::pow(Value(base), e);
+				if (std::isfinite(r) && r == std::floor(r) && std::fabs(r) < 1e7) return Number(r);
+			}
+			// (a^b)^n = a^(b*n) при любом a, только если b и n целые: (x^0.5)^2 не x при x < 0
+			if (base->type == FuncType::POW && e == std::floor(e) && IsNum(base->Arg(1)) && Value(base->Arg(1)) == std::floor(Value(base->Arg(1))))
+				return BuildPow(base->Arg(0), BuildProduct({ base->Arg(1), exp }));
+		}
+		return Make<Pow>(base, exp);
+	}
+
+	Func* Simplifier::BuildDivision(Func* a, Func* b) {
+		if (IsZero(a)) return Make<Num>(0);
+		if (IsOne(b)) return a;
+		if (a == b) return Make<Num>(1);
+		if (IsNeg(a)) return BuildSum({ { BuildDivision(a->Arg(1), b), -1.0 } });
+		if (IsNum(a) && Value(a) < 0) return BuildSum({ { BuildDivision(Number(-Value(a)), b), -1.0 } });
+		if (IsNum(a) && IsNum(b) && !IsZero(b)) {
+			double q = Value(a) / Value(b);
+			if (q == std::floor(q)) return Number(q);
+		}
+		return Make<Division>(a, b);
+	}
+
+	Func* Simplifier::BuildUnary(FuncType type, Func* a) {
+		switch (type) {
+		case FuncType::SIN:
+			return IsZero(a) ? Make<Num>(0) : Make<Sin>(a);
+		case FuncType::COS:
+			return IsZero(a) ? Make<Num>(1) : Make<Cos>(a);
+		case FuncType::TG:
+			return IsZero(a) ? Make<Num>(0) : Make<Tg>(a);
+		case FuncType::CTG:
+			return Make<Ctg>(a);
+		case FuncType::LN:
+			if (IsOne(a)) return Make<Num>(0);
+			if (a->type == FuncType::E) return Make<Num>(1);
+			if (a->type == FuncType::POW && a->Arg(0)->type == FuncType::E) return a->Arg(1);
+			return Make<Ln>(a);
+		case FuncType::LG:
+			if (IsOne(a)) return Make<Num>(0);
+			if (IsNum(a) && Value(a) == 10.0) return Make<Num>(1);
+			return Make<Lg>(a);
+		default: {
+			if (IsNum(a) && Value(a) >= 0) {
+				double r = std::sqrt(Value(a));
+				if (r == std::floor(r)) return Number(r);
+			}
+			return Make<Sqrt>(a);
+		}
+		}
+	}
+}
+
+Func* Simplify(Func* f) {
+	DERIVATIVE_STATS_ONLY(stats::Timer timer(stats::Phase::SIMPLIFY));
+	Simplifier simplifier;
+	return simplifier.Run(f);
+}
+
+Func* Derivative(Func* f, int n) {
+	Func* result = Simplify(f);
+	for (int i = 0; i < n; ++i) result = Simplify(result->Der());
+	return result;
+}
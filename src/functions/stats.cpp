@@ -0,0 +1,126 @@
+﻿#include <functions/stats.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include <ostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace stats {
+	namespace {
+		thread_local Counters counters;
+		// вложенность этапов в текущем потоке
+		thread_local std::array<std::uint32_t, kPhases> running{};
+
+		const char* types[kTypes] = {
+			"num", "e", "pi", "x", "sum", "sub", "mult", "division",
+			"sin", "cos", "tg", "ctg", "ln", "lg", "pow", "sqrt", "var"
+		};
+
+		const char* phases[kPhases] = { "tokenize", "parse", "differentiate", "simplify", "print" };
+
+		void Add(Shape& total, const Shape& shape) {
+			total.nodes += shape.nodes;
+			total.tree += shape.tree;
+			total.depth = std::max(total.depth, shape.depth);
+		}
+
+		void Write(std::ostream& os, const char* name, const Shape& shape) {
+			char text[128];
+			std::snprintf(text, sizeof(text), "\"%s\": {\"nodes\": %llu, \"tree\": %.17g, \"depth\": %llu}", name,
+				static_cast<unsigned long long>(shape.nodes), std::min(shape.tree, DBL_MAX), static_cast<unsigned long long>(shape.depth));
+			os << text;
+		}
+	}
+
+	Counters& Counters::operator+=(const Counters& other) {
+		for (size_t i = 0; i < kTypes; ++i) {
+			made[i] += other.made[i];
+			created[i] += other.created[i];
+		}
+		bytes += other.bytes;
+		derivatives += other.derivatives;
+		Add(before, other.before);
+		Add(after, other.after);
+		for (size_t i = 0; i < kPhases; ++i) {
+			nanoseconds[i] += other.nanoseconds[i];
+			calls[i] += other.calls[i];
+		}
+		return *this;
+	}
+
+	Counters& Local() {
+		return counters;
+	}
+
+	void Reset() {
+		counters = Counters();
+	}
+
+	Shape Measure(const Func* f) {
+		// для каждой подфункции: число узлов дерева и глубина
+		std::unordered_map<const Func*, std::pair<double, std::uint64_t>> sizes;
+		std::vector<std::pair<const Func*, bool>> stack{ { f, false } };
+		while (!stack.empty()) {
+			auto [g, expanded] = stack.back();
+			if (sizes.count(g)) {
+				stack.pop_back();
+				continue;
+			}
+			if (!expanded) {
+				stack.back().second = true;
+				for (int i = 0; i < g->Arity(); ++i)
+					if (!sizes.count(g->Arg(i))) stack.push_back({ g->Arg(i), false });
+				continue;
+			}
+			stack.pop_back();
+			std::pair<double, std::uint64_t> size{ 1.0, 1 };
+			for (int i = 0; i < g->Arity(); ++i) {
+				const auto& arg = sizes.at(g->Arg(i));
+				size.first += arg.first;
+				size.second = std::max(size.second, arg.second + 1);
+			}
+			sizes.emplace(g, size);
+		}
+		const auto& root = sizes.at(f);
+		return { sizes.size(), root.first, root.second };
+	}
+
+	void Record(const Shape& f, const Shape& der) {
+		++counters.derivatives;
+		Add(counters.before, f);
+		Add(counters.after, der);
+	}
+
+	void Dump(const Counters& c, std::ostream& os) {
+		os << "{\"enabled\": " << (kEnabled ? "true" : "false") << ", \"nodes\": {";
+		for (size_t i = 0; i < kTypes; ++i)
+			os << (i ? ", \"" : "\"") << types[i] << "\": {\"made\": " << c.made[i] << ", \"created\": " << c.created[i] << '}';
+		os << "}, \"arena_bytes\": " << c.bytes << ", \"der\": {\"calls\": " << c.derivatives << ", ";
+		Write(os, "before", c.before);
+		os << ", ";
+		Write(os, "after", c.after);
+		os << "}, \"phases\": {";
+		for (size_t i = 0; i < kPhases; ++i)
+			os << (i ? ", \"" : "\"") << phases[i] << "\": {\"calls\": " << c.calls[i] << ", \"ns\": " << c.nanoseconds[i] << '}';
+		os << "}}\n";
+	}
+
+	void Dump(std::ostream& os) {
+		Dump(counters, os);
+	}
+
+	Timer::Timer(Phase p) : phase(static_cast<size_t>(p)), outer(running[phase]++ == 0) {
+		if (outer) start = std::chrono::steady_clock::now();
+	}
+
+	Timer::~Timer() {
+		--running[phase];
+		if (!outer) return;
+		counters.nanoseconds[phase] += static_cast<std::uint64_t>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+		++counters.calls[phase];
+	}
+}
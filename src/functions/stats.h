@@ -0,0 +1,144 @@
+﻿#ifndef FUNCTIONS_STATS_H_20261018
+#define FUNCTIONS_STATS_H_20261018
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+
+#include <functions/functions.h>
+
+/*!
+\brief Макрос, оставляющий свои аргументы только в сборке со счетчиками
+
+Счетчики включаются определением DERIVATIVE_STATS (опция CMake DERIVATIVE_STATS).
+Без него места подсчета в библиотеке пусты и ничего не стоят
+*/
+#ifdef DERIVATIVE_STATS
+#define DERIVATIVE_STATS_ONLY(...) __VA_ARGS__
+#else
+#define DERIVATIVE_STATS_ONLY(...)
+#endif
+
+/*!
+\brief Пространство имен, содержащее счетчики работы библиотеки
+
+Счетчики свои у каждого потока и копятся с начала потока или с последнего Reset().
+По ним видно, что именно медленно: экспоненциально растущая функция (tree_after
+много больше nodes_after, большое время печати) или один из этапов
+
+Пример
+\code
+stats::Reset();
+Func* f = simpleparser::Parser(text).Parse();
+std::cout << *Simplify(f->Der());
+stats::Dump(std::cerr);
+\endcode
+*/
+namespace stats {
+
+	/// Включены ли счетчики в этой сборке
+#ifdef DERIVATIVE_STATS
+	constexpr bool kEnabled = true;
+#else
+	constexpr bool kEnabled = false;
+#endif
+
+	/// Перечисление, содержащее этапы, время которых измеряется
+	enum class Phase {
+		TOKENIZE,
+		PARSE,
+		DIFFERENTIATE,
+		SIMPLIFY,
+		PRINT
+	};
+
+	/// Количество этапов
+	constexpr size_t kPhases = static_cast<size_t>(Phase::PRINT) + 1;
+	/// Количество типов функций
+	constexpr size_t kTypes = static_cast<size_t>(FuncType::VAR) + 1;
+
+	/// Размер функции
+	struct Shape {
+		/// Различные подфункции
+		std::uint64_t nodes{ 0 };
+		/// Узлы дерева, если общие подфункции раскрыть; столько частей в repr()
+		double tree{ 0.0 };
+		/// Глубина
+		std::uint64_t depth{ 0 };
+	};
+
+	/// Счетчики одного потока
+	struct Counters {
+		/// Вызовы Make() по типам функций
+		std::array<std::uint64_t, kTypes> made{};
+		/// Новые функции по типам; остальные вызовы Make() вернули уже имеющиеся
+		std::array<std::uint64_t, kTypes> created{};
+		/// Байты, выделенные под блоки арен хранилищ; таблица функций хранилища и запомненные производные не считаются
+		std::uint64_t bytes{ 0 };
+		/// Вызовы Der(), не нашедшие готовой производной
+		std::uint64_t derivatives{ 0 };
+		/// Размер функций до Der(): суммы nodes и tree, наибольшая depth
+		Shape before;
+		/// Размер производных
+		Shape after;
+		/// Время этапов в наносекундах; вложенный вызов того же этапа не считается
+		std::array<std::uint64_t, kPhases> nanoseconds{};
+		/// Вызовы этапов
+		std::array<std::uint64_t, kPhases> calls{};
+		/// Оператор, добавляющий счетчики другого потока
+		Counters& operator+=(const Counters& other);
+	};
+
+	/// Счетчики текущего потока
+	Counters& Local();
+
+	/// Функция обнуляет счетчики текущего потока
+	void Reset();
+
+	/*!
+	\brief Функция измеряет размер функции обходом с явным стеком
+	\param[in] f функция
+	\return Shape размер
+	*/
+	Shape Measure(const Func* f);
+
+	/*!
+	\brief Функция записывает размеры функции и ее производной в счетчики потока
+	\param[in] f функция
+	\param[in] der производная
+	*/
+	void Record(const Shape& f, const Shape& der);
+
+	/*!
+	\brief Функция записывает счетчики в поток в формате JSON
+	\param[in] counters счетчики
+	\param[out] os поток
+	*/
+	void Dump(const Counters& counters, std::ostream& os);
+
+	/// Dump() для счетчиков текущего потока
+	void Dump(std::ostream& os);
+
+	/*!
+	\brief Класс, добавляющий время своей жизни ко времени этапа
+
+	Если этап уже идет в этом потоке (например, Der() внутри Der()), время не
+	добавляется второй раз
+	*/
+	class Timer {
+	public:
+		/// Конструктор, начинающий отсчет этапа phase
+		explicit Timer(Phase phase);
+		Timer(const Timer&) = delete;
+		Timer& operator=(const Timer&) = delete;
+		/// Деструктор, добавляющий время этапа
+		~Timer();
+	private:
+		size_t phase;
+		bool outer;
+		std::chrono::steady_clock::time_point start;
+	};
+}
+
+#endif // !FUNCTIONS_STATS_H_20261018
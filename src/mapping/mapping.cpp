@@ -0,0 +1,78 @@
+﻿#include <mapping/mapping.h>
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mapping {
+	namespace {
+		[[noreturn]] void Fail(const std::string& path, const char* what) {
+			throw std::runtime_error("mapping: " + std::string(what) + " " + path);
+		}
+	}
+
+#ifdef _WIN32
+	MappedFile::MappedFile(const std::string& path) {
+		file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			file = nullptr;
+			Fail(path, "cannot open file");
+		}
+		LARGE_INTEGER length;
+		if (!GetFileSizeEx(file, &length)) {
+			CloseHandle(file);
+			Fail(path, "cannot read file size");
+		}
+		size = static_cast<size_t>(length.QuadPart);
+		if (size == 0) return;
+		section = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		data = section ? MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		if (!data) {
+			if (section) CloseHandle(section);
+			CloseHandle(file);
+			Fail(path, "cannot map file");
+		}
+	}
+
+	MappedFile::~MappedFile() {
+		if (data) UnmapViewOfFile(data);
+		if (section) CloseHandle(section);
+		if (file) CloseHandle(file);
+	}
+#else
+	MappedFile::MappedFile(const std::string& path) {
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0) Fail(path, "cannot open file");
+		struct stat info;
+		if (fstat(fd, &info) != 0) {
+			close(fd);
+			Fail(path, "cannot read file size");
+		}
+		size = static_cast<size_t>(info.st_size);
+		if (size > 0) {
+			data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data == MAP_FAILED) {
+				data = nullptr;
+				close(fd);
+				Fail(path, "cannot map file");
+			}
+		}
+		// отображение остается действительным и после закрытия файла
+		close(fd);
+	}
+
+	MappedFile::~MappedFile() {
+		if (data) munmap(data, size);
+	}
+#endif
+}
@@ -0,0 +1,39 @@
+﻿#ifndef MAPPING_MAPPING_H_20261018
+#define MAPPING_MAPPING_H_20261018
+
+#include <cstddef>
+#include <string>
+
+/// Пространство имен, содержащее отображение файлов в память
+namespace mapping {
+
+	/*!
+	\brief Класс, отображающий файл в память только для чтения
+	*/
+	class MappedFile {
+	public:
+		/*!
+		\brief Конструктор, отображающий файл
+		\param[in] path путь к файлу
+		\throw std::runtime_error если файл не удалось открыть или отобразить
+		*/
+		explicit MappedFile(const std::string& path);
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		/// Деструктор, снимающий отображение
+		~MappedFile();
+		/// Начало файла в памяти, выровненное на страницу
+		const void* Data() const noexcept { return data; }
+		/// Размер файла в байтах
+		size_t Size() const noexcept { return size; }
+	private:
+		void* data{ nullptr };
+		size_t size{ 0 };
+#ifdef _WIN32
+		void* file{ nullptr };
+		void* section{ nullptr };
+#endif
+	};
+}
+
+#endif // !MAPPING_MAPPING_H_20261018
@@ -0,0 +1,97 @@
+﻿#include <parse_cache/parse_cache.h>
+
+#include <cctype>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include <serialize/serialize.h>
+
+namespace simpleparser {
+	namespace {
+		bool Word(char ch) {
+			return std::isalnum(static_cast<unsigned char>(ch)) || ch == '_' || ch == '.';
+		}
+	}
+
+	// двоичная запись графа и проверенный один раз вид над ней
+	struct ParseCache::Entry {
+		explicit Entry(std::string data) : bytes(std::move(data)), graph(bytes.data(), bytes.size()) {}
+		const std::string bytes;
+		const serialize::Graph graph;
+	};
+
+	ParseCache::ParseCache(size_t capacity) : capacity(capacity) {}
+
+	std::string ParseCache::Normalize(std::string_view str) {
+		std::string key;
+		key.reserve(str.size());
+		bool space = false;
+		for (char ch : str) {
+			if (std::isspace(static_cast<unsigned char>(ch))) {
+				space = true;
+				continue;
+			}
+			if (space && !key.empty() && Word(key.back()) && Word(ch)) key += ' ';
+			space = false;
+			key += ch;
+		}
+		return key;
+	}
+
+	Func* ParseCache::Parse(const std::string& str) {
+		ParseResult result = TryParse(str);
+		if (!result) throw std::runtime_error(result.error);
+		return result.func;
+	}
+
+	ParseResult ParseCache::TryParse(const std::string& str) {
+		std::string key = Normalize(str);
+		std::shared_ptr<const Entry> entry;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			auto found = entries.find(key);
+			if (found != entries.end()) {
+				order.splice(order.begin(), order, found->second);
+				entry = found->second->second;
+				++stats.hits;
+			}
+			else ++stats.misses;
+		}
+		ParseResult result;
+		if (entry) {
+			result.func = entry->graph.Load().front();
+			return result;
+		}
+		result = Parser(str).TryParse();
+		if (!result || capacity == 0) return result;
+		std::ostringstream os;
+		serialize::Write({ result.func }, os);
+		entry = std::make_shared<const Entry>(os.str());
+		std::lock_guard<std::mutex> lock(mutex);
+		if (entries.count(key)) return result;
+		order.emplace_front(std::move(key), std::move(entry));
+		entries.emplace(order.front().first, order.begin());
+		while (order.size() > capacity) {
+			entries.erase(order.back().first);
+			order.pop_back();
+		}
+		return result;
+	}
+
+	size_t ParseCache::Size() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return order.size();
+	}
+
+	ParseCache::Statistics ParseCache::Stats() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return stats;
+	}
+
+	void ParseCache::Clear() {
+		std::lock_guard<std::mutex> lock(mutex);
+		entries.clear();
+		order.clear();
+	}
+}
@@ -0,0 +1,90 @@
+﻿#ifndef PARSE_CACHE_PARSE_CACHE_H_20261018
+#define PARSE_CACHE_PARSE_CACHE_H_20261018
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <parser/parser.h>
+
+namespace simpleparser {
+
+	/*!
+	\brief Ограниченный LRU-кэш разбора, ключ - текст функции без лишних пробелов
+
+	Функции из Parse() принадлежат хранилищу вызывающего потока, поэтому кэш хранит
+	не их, а неизменяемую двоичную запись разобранного графа (serialize::Write()),
+	которую можно делить между потоками. При попадании токены и разбор не нужны:
+	функция собирается из записи в FuncStore::Current() одним проходом по таблице узлов.
+	Поиск можно вызывать из нескольких потоков одновременно.
+
+	Пример
+	\code
+	simpleparser::ParseCache parses(1024);
+	Func* f = parses.Parse("sin(x) * x");
+	Func* g = parses.Parse("sin( x )*x"); // попадание, g == f
+	\endcode
+	*/
+	class ParseCache {
+	public:
+		/// Счетчики кэша
+		struct Statistics {
+			/// Найдено в кэше
+			std::uint64_t hits{ 0 };
+			/// Разобрано заново
+			std::uint64_t misses{ 0 };
+		};
+		/*!
+		\brief Конструктор кэша
+		\param[in] capacity наибольшее число записей
+		*/
+		explicit ParseCache(size_t capacity);
+		ParseCache(const ParseCache&) = delete;
+		ParseCache& operator=(const ParseCache&) = delete;
+		/*!
+		\brief Метод разбирает строку через кэш
+		\throw std::runtime_error - те же ошибки, что у Parser::Parse()
+		\return Func* функция из FuncStore::Current()
+		*/
+		Func* Parse(const std::string& str);
+		/*!
+		\brief Метод разбирает строку через кэш без исключений
+
+		Ошибки не запоминаются: строка с ошибкой каждый раз разбирается заново, 
+		чтобы положение ошибки относилось к ней самой
+		\return ParseResult то же, что Parser(str).TryParse()
+		*/
+		ParseResult TryParse(const std::string& str);
+		/// Количество записей
+		size_t Size() const;
+		/// Счетчики кэша
+		Statistics Stats() const;
+		/// Метод удаляет все записи
+		void Clear();
+		/*!
+		\brief Функция приводит запись функции к ключу кэша
+
+		Пробелы удаляются, кроме одного между буквами и цифрами, где они разделяют 
+		токены ("x y" не то же, что "xy")
+		\param[in] str запись функции
+		\return std::string ключ
+		*/
+		static std::string Normalize(std::string_view str);
+	private:
+		struct Entry;
+		using Item = std::pair<std::string, std::shared_ptr<const Entry>>;
+		size_t capacity;
+		mutable std::mutex mutex;
+		// записи от недавних к давним
+		std::list<Item> order;
+		std::unordered_map<std::string_view, std::list<Item>::iterator> entries;
+		Statistics stats;
+	};
+}
+
+#endif // !PARSE_CACHE_PARSE_CACHE_H_20261018
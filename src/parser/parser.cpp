@@ -1,119 +1,368 @@
-#include <parser/parser.h>
-#include <algorithm>
+﻿#include <parser/parser.h>
+#include <cctype>
+#include <charconv>
+#include <istream>
+#include <utility>
+
+#include <functions/stats.h>
+#include <mapping/mapping.h>
 
 namespace simpleparser {
-	// TOKEN
-	const enum class TokenType Token::found() const noexcept {
-		if (names.find(text) != names.end()) return names.find(text)->second;
-		else return TokenType::NONE;
-	}
 	// TOKENIZER
-	std::vector<Token> Tokenizer::Tokenize(const std::string& str) {
-		std::vector<Token> tokens;
-		Token currentToken;
-		for (char ch : str) {
-			if (ch == ' ') {
-				endToken(currentToken, tokens);
-				continue;
-			}
-			else if (std::any_of(currentToken.text.begin(), currentToken.text.end(), [](int c){ return isalpha(c); }) && isdigit(ch)) {
-				throw std::runtime_error("Syntax error");
-			}
-			else if ((currentToken.type == TokenType::WHITESPACE || currentToken.type == TokenType::NUMERICAL) && isdigit(ch) || ch == '.') {
-				currentToken.type = TokenType::NUMERICAL;
+	namespace {
+		size_t Match(std::string_view s, std::string_view word, TokenType t, TokenType& type) noexcept {
+			if (s.substr(0, word.size()) != word) return 0;
+			type = t;
+			return word.size();
+		}
+		// префиксное дерево ключевых слов: ветвление по первой и второй букве и одно сравнение;
+		// возвращает длину ключевого слова в начале s либо 0
+		size_t Keyword(std::string_view s, TokenType& type) noexcept {
+			char second = s.size() > 1 ? s[1] : '\0';
+			switch (s[0]) {
+			case 'x': return Match(s, "x", TokenType::X, type);
+			case 'e': return Match(s, "e", TokenType::E, type);
+			case 'p': return Match(s, "pi", TokenType::PI, type);
+			case 't': return Match(s, "tg", TokenType::TG, type);
+			case 's': return second == 'q' ? Match(s, "sqrt", TokenType::SQRT, type) : Match(s, "sin", TokenType::SIN, type);
+			case 'c': return second == 't' ? Match(s, "ctg", TokenType::CTG, type) : Match(s, "cos", TokenType::COS, type);
+			case 'l': return second == 'g' ? Match(s, "lg", TokenType::LG, type) : Match(s, "ln", TokenType::LN, type);
+			default: return 0;
 			}
-			else if (currentToken.type == TokenType::NUMERICAL && !isdigit(ch) && ch != '.') {
-				endToken(currentToken, tokens);
+		}
+		TokenType Symbol(char ch) noexcept {
+			switch (ch) {
+			case '+': return TokenType::PLUS;
+			case '-': return TokenType::MINUS;
+			case '*': return TokenType::MULT;
+			case '/': return TokenType::DIVISION;
+			case '^': return TokenType::POWER;
+			case '(': case '[': case '{': return TokenType::OPEN_BRACKET;
+			case ')': case ']': case '}': return TokenType::CLOSED_BRACKET;
+			default: return TokenType::NONE;
 			}
-			currentToken.text += ch;
-			enum TokenType found = currentToken.found();
-			if (found != TokenType::NONE) {
-				currentToken.type = found;
-				endToken(currentToken, tokens);
+		}
+		bool IsDigit(char ch) noexcept { return ch >= '0' && ch <= '9'; }
+		bool IsLetter(char ch) noexcept { return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '_'; }
+		bool IsFunction(TokenType type) noexcept { return type >= TokenType::SIN && type <= TokenType::LG; }
+		// имя, целиком составленное из ключевых слов, после функции возможно число (sinx, cosx, 
+		// ln2, pix); возвращает длину первого ключевого слова и его тип либо 0
+		size_t Compound(std::string_view name, TokenType& type) noexcept {
+			size_t pos = 0, head = 0;
+			TokenType current = TokenType::NONE;
+			while (pos < name.size()) {
+				if (IsDigit(name[pos])) {
+					if (!IsFunction(current)) return 0;
+					for (; pos < name.size(); ++pos)
+						if (!IsDigit(name[pos])) return 0;
+					break;
+				}
+				size_t length = Keyword(name.substr(pos), current);
+				if (length == 0) return 0;
+				if (pos == 0) {
+					head = length;
+					type = current;
+				}
+				pos += length;
 			}
+			return head;
 		}
-		endToken(currentToken, tokens);
+	}
+	std::vector<Token> Tokenizer::Tokenize(std::string_view str) {
+		std::vector<Token> tokens;
+		if (TryTokenize(str, tokens) != std::string_view::npos) throw std::runtime_error("Syntax error");
 		return tokens;
 	}
-	void Tokenizer::endToken(Token& token, std::vector<Token>& tokens) {
-		if (token.type != TokenType::WHITESPACE) {
-			tokens.push_back(token);
-			token.type = TokenType::WHITESPACE;
-			token.text.erase();
+	size_t Tokenizer::TryTokenize(std::string_view str, std::vector<Token>& tokens) {
+		DERIVATIVE_STATS_ONLY(stats::Timer timer(stats::Phase::TOKENIZE));
+		tokens.clear();
+		TokenStream stream(str);
+		while (stream.Next())
+			tokens.emplace_back(stream.Type(), static_cast<std::uint32_t>(stream.Offset()), static_cast<std::uint32_t>(stream.Text().size()));
+		return stream.Bad();
+	}
+	// дочитывает поток, оставляя в буфере только текст с начала текущего токена
+	bool TokenStream::Fill() {
+		constexpr size_t kBlock = 1 << 16;
+		if (!is || !*is) return false;
+		buffer.erase(0, pos);
+		base += pos;
+		pos = 0;
+		size_t size = buffer.size();
+		buffer.resize(size + kBlock);
+		is->read(&buffer[size], kBlock);
+		buffer.resize(size + static_cast<size_t>(is->gcount()));
+		data = buffer;
+		return buffer.size() > size;
+	}
+	// есть ли символ data[pos + i], дочитывая поток при необходимости
+	bool TokenStream::Available(size_t i) {
+		while (pos + i >= data.size())
+			if (!Fill()) return false;
+		return true;
+	}
+	bool TokenStream::Next() {
+		if (bad != std::string_view::npos) return false;
+		pos += length;
+		length = 0;
+		while (Available(0) && std::isspace(static_cast<unsigned char>(data[pos]))) ++pos;
+		type = TokenType::WHITESPACE;
+		if (pos == data.size()) return false;
+		char ch = data[pos];
+		type = Symbol(ch);
+		if (type != TokenType::NONE) length = 1;
+		else if (IsDigit(ch) || ch == '.') {
+			// число: цифры и не больше одной точки
+			type = TokenType::NUMERICAL;
+			size_t points = 0;
+			while (Available(length) && (IsDigit(data[pos + length]) || data[pos + length] == '.')) {
+				if (data[pos + length] == '.') ++points;
+				++length;
+			}
+			if (points > 1 || length == points) length = 0;
+		}
+		else if (IsLetter(ch)) {
+			// имя: ключевое слово, если совпадает с ним целиком, иначе переменная
+			while (Available(length) && (IsLetter(data[pos + length]) || IsDigit(data[pos + length]))) ++length;
+			if (Keyword(Text(), type) != length) {
+				// слитная запись из ключевых слов значит то же, что раздельная: sinx - sin x; 
+				// pix и ex не становятся переменными, а отвергаются
+				size_t head = Compound(Text(), type);
+				if (head == 0) type = TokenType::VARIABLE;
+				else length = IsFunction(type) ? head : 0;
+			}
+		}
+		if (length == 0) {
+			bad = Offset();
+			return false;
 		}
+		return true;
 	}
 	// PARSER
-	Parser::Parser(const std::string& str) {
+	namespace {
+		// приоритеты бинарных операций; функции в позиции операции имеют высший приоритет 
+		// и дают ошибку при свертке, прочие токены завершают выражение
+		constexpr int precedence[] = {
+			-1, // WHITESPACE
+			0, // NUMERICAL
+			1, // PLUS
+			1, // MINUS
+			2, // MULT
+			2, // DIVISION
+			3, // POWER
+			0, // PI
+			0, // E
+			0, // X
+			0, // VARIABLE
+			0, // OPEN_BRACKET
+			0, // CLOSED_BRACKET
+			4, // SIN
+			4, // COS
+			4, // TG
+			4, // CTG
+			4, // SQRT
+			4, // LN
+			4, // LG
+			0 // NONE
+		};
+		static_assert(sizeof(precedence) / sizeof(precedence[0]) == static_cast<int>(TokenType::NONE) + 1);
+
+		int Precedence(TokenType type) { return precedence[static_cast<int>(type)]; }
+
+		Func* MakeFunc(TokenType type, Func* arg) {
+			switch (type) {
+			case TokenType::MINUS: return Make<Sub>(Make<Num>(0.0f), arg);
+			case TokenType::SIN: return Make<Sin>(arg);
+			case TokenType::COS: return Make<Cos>(arg);
+			case TokenType::LN: return Make<Ln>(arg);
+			case TokenType::LG: return Make<Lg>(arg);
+			case TokenType::SQRT: return Make<Sqrt>(arg);
+			case TokenType::TG: return Make<Tg>(arg);
+			case TokenType::CTG: return Make<Ctg>(arg);
+			default: return nullptr;
+			}
+		}
+
+		Func* MakeFunc(Func* f1, TokenType type, Func* f2) {
+			switch (type) {
+			case TokenType::PLUS: return Make<Sum>(f1, f2);
+			case TokenType::MINUS: return Make<Sub>(f1, f2);
+			case TokenType::MULT: return Make<Mult>(f1, f2);
+			case TokenType::DIVISION: return Make<Division>(f1, f2);
+			case TokenType::POWER: return Make<Pow>(f1, f2);
+			default: return nullptr;
+			}
+		}
+
+		// элемент стека операций; вместо текста токена хранится его первый символ, 
+		// потому что текст из TokenStream живет только до следующего токена
+		struct Pending {
+			enum class Kind { PREFIX, BINARY, BRACKET } kind;
+			TokenType type;
+			size_t offset;
+			char symbol;
+		};
+
+		std::string Name(const Pending& op) {
+			switch (op.type) {
+			case TokenType::SIN: return "sin";
+			case TokenType::COS: return "cos";
+			case TokenType::TG: return "tg";
+			case TokenType::CTG: return "ctg";
+			case TokenType::SQRT: return "sqrt";
+			case TokenType::LN: return "ln";
+			case TokenType::LG: return "lg";
+			default: return std::string(1, op.symbol);
+			}
+		}
+
+		// готовые токены Parser в том же виде, что TokenStream
+		class TokenList {
+		public:
+			TokenList(const std::vector<Token>& tokens, std::string_view source) : tokens(tokens), source(source) {}
+			bool Next() noexcept { return ++k < tokens.size(); }
+			TokenType Type() const noexcept { return tokens[k].type; }
+			std::string_view Text() const noexcept { return tokens[k].Text(source); }
+			size_t Offset() const noexcept { return k < tokens.size() ? tokens[k].offset : source.size(); }
+			size_t Bad() const noexcept { return std::string_view::npos; }
+		private:
+			const std::vector<Token>& tokens;
+			std::string_view source;
+			size_t k{ static_cast<size_t>(-1) };
+		};
+
+		// разбор по таблице приоритетов; токены берутся по одному из TokenList или TokenStream
+		template <class Tokens>
+		ParseResult Run(Tokens& tokens) {
+			DERIVATIVE_STATS_ONLY(stats::Timer timer(stats::Phase::PARSE));
+			auto fail = [](std::string error, size_t offset) {
+				ParseResult result;
+				result.error = std::move(error);
+				result.offset = offset;
+				return result;
+			};
+			// префиксная функция применяется к одному простому выражению (числу, переменной, скобке или 
+			// другой префиксной функции), бинарные операции левоассоциативны
+			std::vector<Func*> values;
+			std::vector<Pending> ops;
+			using Kind = Pending::Kind;
+			// сворачивает префиксные функции над только что законченным простым выражением
+			auto prefixes = [&]() -> const Pending* {
+				while (!ops.empty() && ops.back().kind == Kind::PREFIX) {
+					Func* f = MakeFunc(ops.back().type, values.back());
+					if (!f) return &ops.back();
+					values.back() = f;
+					ops.pop_back();
+				}
+				return nullptr;
+			};
+			// сворачивает бинарные операции с приоритетом не ниже level
+			auto binaries = [&](int level) -> const Pending* {
+				while (!ops.empty() && ops.back().kind == Kind::BINARY && Precedence(ops.back().type) >= level) {
+					Func* right = values.back();
+					values.pop_back();
+					Func* f = MakeFunc(values.back(), ops.back().type, right);
+					if (!f) return &ops.back();
+					values.back() = f;
+					ops.pop_back();
+				}
+				return nullptr;
+			};
+			bool operand = true;
+			for (bool first = true;; first = false) {
+				bool end = !tokens.Next();
+				if (end && tokens.Bad() != std::string_view::npos) return fail("Syntax error", tokens.Bad());
+				if (end && first) return fail("Function is empty or not allowed", 0);
+				TokenType type = end ? TokenType::WHITESPACE : tokens.Type();
+				size_t offset = tokens.Offset();
+				if (operand) {
+					switch (type) {
+					case TokenType::NUMERICAL: {
+						std::string_view text = tokens.Text();
+						float value = 0.0f;
+						if (std::from_chars(text.data(), text.data() + text.size(), value).ec != std::errc())
+							return fail("Syntax error", offset);
+						values.push_back(Make<Num>(value));
+						break;
+					}
+					case TokenType::X: values.push_back(Make<X>()); break;
+					case TokenType::VARIABLE: values.push_back(Make<Var>(tokens.Text())); break;
+					case TokenType::PI: values.push_back(Make<PI>()); break;
+					case TokenType::E: values.push_back(Make<E>()); break;
+					case TokenType::OPEN_BRACKET:
+						ops.push_back({ Kind::BRACKET, type, offset, tokens.Text()[0] });
+						continue;
+					case TokenType::WHITESPACE: {
+						// ошибка относится к ближайшей ожидающей аргумента функции
+						for (auto it = ops.rbegin(); it != ops.rend(); ++it)
+							if (it->kind == Kind::PREFIX)
+								return fail("Missing argument for " + Name(*it) + " function", offset);
+						return fail("Second operand is missing", offset);
+					}
+					default:
+						ops.push_back({ Kind::PREFIX, type, offset, tokens.Text()[0] });
+						continue;
+					}
+					if (const Pending* wrong = prefixes()) return fail("Function is not allowed", wrong->offset);
+					operand = false;
+					continue;
+				}
+				int level = Precedence(type);
+				if (level > 0) {
+					if (const Pending* wrong = binaries(level)) return fail("Function is not allowed", wrong->offset);
+					ops.push_back({ Kind::BINARY, type, offset, tokens.Text()[0] });
+					operand = true;
+					continue;
+				}
+				if (const Pending* wrong = binaries(0)) return fail("Function is not allowed", wrong->offset);
+				bool bracket = !ops.empty() && ops.back().kind == Kind::BRACKET;
+				if (type == TokenType::CLOSED_BRACKET && bracket) {
+					ops.pop_back();
+					if (const Pending* wrong = prefixes()) return fail("Function is not allowed", wrong->offset);
+					continue;
+				}
+				if (bracket) return fail("Expected closing bracket", offset);
+				if (!end) return fail("Unexpected token", offset);
+				break;
+			}
+			ParseResult result;
+			result.func = values.back();
+			return result;
+		}
+	}
+	Parser::Parser(const std::string& str) : source(str) {
 		Tokenizer tz;
-		tokens = tz.Tokenize(str);
+		bad = tz.TryTokenize(source, tokens);
 	}
 	Func* Parser::Parse() {
-		if (tokens.size() == 0) throw std::runtime_error("Function is empty or not allowed");
-		return ParseBinaryExpression(0);
-	}
-	Token Parser::GetToken() {
-		if (i + 1 >= (int)tokens.size()) return Token();
-		return tokens[++i];
-	}
-	Func* Parser::MakeFunc(Token t, Func* arg) {
-		if (t.type == TokenType::MINUS) return new Sub(new Num(0.0f), arg);
-		if (t.type == TokenType::SIN) return new Sin(arg);
-		if (t.type == TokenType::COS) return new Cos(arg);
-		if (t.type == TokenType::LN) return new Ln(arg);
-		if (t.type == TokenType::LG) return new Lg(arg);
-		if (t.type == TokenType::SQRT) return new Sqrt(arg);
-		if (t.type == TokenType::TG) return new Tg(arg);
-		if (t.type == TokenType::CTG) return new Ctg(arg);
-		throw std::runtime_error("Function is not allowed");
+		ParseResult result = TryParse();
+		if (!result) throw std::runtime_error(result.error);
+		return result.func;
 	}
-	Func* Parser::MakeFunc(Func* f1, Token op, Func* f2) {
-		if (op.type == TokenType::PLUS) return new Sum(f1, f2);
-		if (op.type == TokenType::MINUS) return new Sub(f1, f2);
-		if (op.type == TokenType::MULT) return new Mult(f1, f2);
-		if (op.type == TokenType::DIVISION) return new Division(f1, f2);
-		if (op.type == TokenType::POWER) return new Pow(f1, f2);
-		throw std::runtime_error("Function is not allowed");
-	}
-	Func* Parser::ParseSimpleExpression() {
-		Token token = GetToken();
-		if (token.type == TokenType::NUMERICAL) 
-			return new Num(std::stof(token.text));
-		if (token.type == TokenType::X) 
-			return new X();
-		if (token.type == TokenType::PI) 
-			return new PI();
-		if (token.type == TokenType::E) 
-			return new E();
-		if (token.type == TokenType::OPEN_BRACKET) {
-			Func* result = ParseBinaryExpression(0);
-			if (GetToken().type != TokenType::CLOSED_BRACKET) 
-				throw std::runtime_error("Expected closing bracket");
+	ParseResult Parser::TryParse() {
+		if (bad != std::string_view::npos) {
+			ParseResult result;
+			result.error = "Syntax error";
+			result.offset = bad;
 			return result;
 		}
-		if (token.type == TokenType::WHITESPACE) 
-			throw std::runtime_error("Second operand is missing");
-		try {
-			Func* argument = ParseSimpleExpression();
-			return MakeFunc(token, argument);
-		}
-		catch (std::runtime_error e) {
-			std::string what = e.what();
-			if (what == "Second operand is missing")
-				throw std::runtime_error("Missing argument for " + token.text + " function");
-			else
-				throw;
-		}
+		TokenList list(tokens, source);
+		return Run(list);
 	}
-	Func* Parser::ParseBinaryExpression(int order) {
-		Func* left_exp = ParseSimpleExpression();
-		for (;;) {
-			Token op = GetToken();
-			if (orders[op.type] <= order) {
-				--i;
-				return left_exp;
-			}
-			Func* right_exp = ParseBinaryExpression(orders[op.type]);
-			left_exp = MakeFunc(left_exp, op, right_exp);
-		}
+	ParseResult TryParse(std::istream& is) {
+		TokenStream stream(is);
+		return Run(stream);
+	}
+	Func* Parse(std::istream& is) {
+		ParseResult result = TryParse(is);
+		if (!result) throw std::runtime_error(result.error);
+		return result.func;
+	}
+	Func* ParseFile(const std::string& path) {
+		mapping::MappedFile file(path);
+		TokenStream stream(std::string_view(static_cast<const char*>(file.Data()), file.Size()));
+		ParseResult result = Run(stream);
+		if (!result) throw std::runtime_error(result.error);
+		return result.func;
 	}
 }
\ No newline at end of file
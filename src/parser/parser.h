@@ -1,9 +1,11 @@
 ﻿#ifndef PARSER_PARSER_H_20211229
 #define PARSER_PARSER_H_20211229
 
+#include <cstdint>
+#include <iosfwd>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_map>
 #include <stdexcept>
 
 #include <functions/functions.h>
@@ -23,6 +25,7 @@ namespace simpleparser {
 		PI,
 		E,
 		X,
+		VARIABLE,
 		OPEN_BRACKET,
 		CLOSED_BRACKET,
 		SIN,
@@ -38,7 +41,8 @@ namespace simpleparser {
 	\brief Класс содержащий описание токенов 
 
 	Token атомарная единица парсинга строки в математическую функцию, будь то 
-	числа, простейшие функции, операторы, скобки
+	числа, простейшие функции, операторы, скобки. Токен не хранит текст, а 
+	указывает на него положением во входной строке, поэтому не выделяет память
 
 	*/
 	class Token {
@@ -55,36 +59,24 @@ namespace simpleparser {
 		Token& operator=(Token&&) = default;
 		/// Деструктор
 		~Token() = default;
-		/// Тип токена
-		enum class TokenType type { TokenType::WHITESPACE };
 		/*!
-		* \brief Метод находит соответствующий тексту тип токена
-		* 
-		* При отсутствии соответствующего типа возвращает TokenType::NONE
-		* \return enum class TokenType
+		\brief Конструктор класса
+		\param[in] t тип токена
+		\param[in] offset, length положение текста токена во входной строке
 		*/
-		const enum class TokenType found() const noexcept;
+		Token(TokenType t, std::uint32_t offset, std::uint32_t length) : type(t), offset(offset), length(length) {}
 		/*!
-		* \brief Текстовая репрезентация токена
+		\brief Метод возвращает текст токена
+		\param[in] source строка, из которой получен токен
+		\return std::string_view
 		*/
-		std::string text{ "" };
-	private:
-		std::unordered_map<std::string, enum class TokenType> names{
-			{"sin", TokenType::SIN}, {"cos", TokenType::COS}, 
-			{"x", TokenType::X}, {"ln", TokenType::LN},
-			{"lg", TokenType::LG}, {"sqrt", TokenType::SQRT}, 
-			{"tg", TokenType::TG}, {"ctg", TokenType::CTG}, 
-			{"^", TokenType::POWER}, {"+", TokenType::PLUS}, 
-			{"-", TokenType::MINUS}, {"/", TokenType::DIVISION}, 
-			{"*", TokenType::MULT}, {"e", TokenType::E},
-			{"pi", TokenType::PI},
-			{"(", TokenType::OPEN_BRACKET},
-			{"[", TokenType::OPEN_BRACKET},
-			{"{", TokenType::OPEN_BRACKET},
-			{"}", TokenType::CLOSED_BRACKET},
-			{"]", TokenType::CLOSED_BRACKET},
-			{")", TokenType::CLOSED_BRACKET}
-		};
+		std::string_view Text(std::string_view source) const noexcept { return source.substr(offset, length); }
+		/// Тип токена
+		TokenType type{ TokenType::WHITESPACE };
+		/// Начало текста токена во входной строке
+		std::uint32_t offset{ 0 };
+		/// Длина текста токена
+		std::uint32_t length{ 0 };
 	};
 	/*!
 	\brief Класс нужный для разбиения строки на токены
@@ -97,9 +89,10 @@ namespace simpleparser {
 
 	int main(){
 		simpleparser::Tokenizer tz;
-		auto x = tz.Tokenize("(x + 22) * cos(x / 2)");
+		std::string input("(x + 22) * cos(x / 2)");
+		auto x = tz.Tokenize(input);
 		for (auto s : x) {
-			std::cout << s.text << " | ";
+			std::cout << s.Text(input) << " | ";
 		}
 		std::cout << "\n\n";
 	}
@@ -121,13 +114,95 @@ namespace simpleparser {
 		~Tokenizer() = default;
 		/*!
 		\brief Метод разбивающий строку на токены
-		\param[in] std::string
-		\throws std::runtime_error - при неправильном вводе чисел
-		\return std::vector<Token>
+
+		Ключевые слова распознаются префиксным деревом, записанным в виде вложенных 
+		switch, поэтому разбор не выделяет память, кроме роста вектора токенов. 
+		Имя (буквы, цифры и _, начиная не с цифры), не совпадающее с ключевым словом 
+		целиком, - переменная: sinh, x1 и speed_2 - переменные. Имя, целиком 
+		составленное из ключевых слов, - слитная запись: sinx и ln2 разбиваются на 
+		функцию и аргумент (sin x, ln 2), а pix, ex и xx - ошибка
+		\param[in] std::string_view
+		\throws std::runtime_error - при неправильном вводе чисел и неизвестных символах
+		\return std::vector<Token> токены, указывающие на str
+		*/
+		std::vector<Token> Tokenize(std::string_view str);
+		/*!
+		\brief Метод разбивает строку на токены без исключений
+		\param[in] str строка
+		\param[out] tokens токены, указывающие на str
+		\return size_t положение первого недопустимого символа либо std::string_view::npos
+		*/
+		size_t TryTokenize(std::string_view str, std::vector<Token>& tokens);
+	};
+
+	/*!
+	\brief Класс, выдающий токены по одному из памяти или из потока
+
+	Токены не собираются в вектор: следующий распознается только при вызове Next(). 
+	Из std::istream текст читается блоками, и в памяти остается только еще не 
+	разобранный хвост блока, поэтому размер входа не ограничен памятью. Правила те же, 
+	что у Tokenizer::TryTokenize()
+
+	Пример
+	\code
+	std::ifstream file("huge.txt");
+	simpleparser::TokenStream tokens(file);
+	while (tokens.Next()) std::cout << tokens.Text() << " | ";
+	if (tokens.Bad() != std::string_view::npos) std::cout << "bad symbol at " << tokens.Bad();
+	\endcode
+	*/
+	class TokenStream {
+	public:
+		/*!
+		\brief Конструктор над строкой в памяти, например отображенным файлом
+		\param[in] str строка; должна жить дольше потока токенов
 		*/
-		std::vector<Token> Tokenize(const std::string& str);
+		explicit TokenStream(std::string_view str) : data(str) {}
+		/*!
+		\brief Конструктор над потоком
+		\param[in] is поток; должен жить дольше потока токенов
+		*/
+		explicit TokenStream(std::istream& is) : is(&is) {}
+		TokenStream(const TokenStream&) = delete;
+		TokenStream& operator=(const TokenStream&) = delete;
+		/*!
+		\brief Метод переходит к следующему токену
+		\return bool false в конце ввода либо на недопустимом символе (тогда Bad() != npos)
+		*/
+		bool Next();
+		/// Тип текущего токена; WHITESPACE в конце ввода
+		TokenType Type() const noexcept { return type; }
+		/// Текст текущего токена; действителен до следующего вызова Next()
+		std::string_view Text() const noexcept { return data.substr(pos, length); }
+		/// Положение текущего токена от начала ввода; в конце ввода - длина ввода
+		size_t Offset() const noexcept { return base + pos; }
+		/// Положение первого недопустимого символа либо std::string_view::npos
+		size_t Bad() const noexcept { return bad; }
 	private:
-		void endToken(Token& token, std::vector<Token>& tokens);
+		bool Fill();
+		bool Available(size_t i);
+		std::istream* is{ nullptr };
+		// непрочитанный хвост потока либо вся строка
+		std::string buffer;
+		std::string_view data;
+		// положение data[0] от начала ввода
+		size_t base{ 0 };
+		size_t pos{ 0 };
+		size_t length{ 0 };
+		TokenType type{ TokenType::WHITESPACE };
+		size_t bad{ std::string_view::npos };
+	};
+
+	/// Результат разбора: функция либо описание ошибки
+	struct ParseResult {
+		/// Функция; nullptr при ошибке
+		Func* func{ nullptr };
+		/// Текст ошибки; пустой при успехе
+		std::string error;
+		/// Положение во входной строке токена, на котором обнаружена ошибка
+		size_t offset{ 0 };
+		/// Разбор успешен
+		explicit operator bool() const noexcept { return func != nullptr; }
 	};
 
 	/*!
@@ -163,6 +238,8 @@ namespace simpleparser {
 		~Parser() = default;
 		/*!
 		\brief Конструктор класса
+
+		Ошибки разбиения на токены сообщаются при разборе
 		\param[in] std::string
 		*/
 		Parser(const std::string& str);
@@ -172,30 +249,50 @@ namespace simpleparser {
 		\throw std::runtime_error - при вводе функции с несбалансированным количеством скобок
 		\throw std::runtime_error - при вводе функции с отсутсвующим вторым операндом
 		\throw std::runtime_error - при вводе функции с отсутствующим аргументом
-		\return Func*. Возвращает математическую функцию 
+		\return Func*. Возвращает математическую функцию, принадлежащую FuncStore::Current()
 		*/
 		Func* Parse();
+		/*!
+		\brief Метод парсит строку без исключений
+
+		Разбор идет по таблице приоритетов с явным стеком операций, поэтому глубина 
+		вложенности скобок и функций ограничена только памятью
+		\return ParseResult функция из FuncStore::Current() либо текст ошибки (тот же, 
+		что в исключении Parse()) и положение токена, на котором она обнаружена
+		*/
+		ParseResult TryParse();
 	private:
+		std::string source;
 		std::vector<Token> tokens;
-		int i{ -1 };
-		std::unordered_map<enum class TokenType, int> orders{
-			{TokenType::SIN, 4}, {TokenType::COS, 4}, 
-			{TokenType::LN, 4}, {TokenType::LG, 4}, 
-			{TokenType::SQRT, 4}, {TokenType::TG, 4}, 
-			{TokenType::CTG, 4}, {TokenType::POWER, 3}, 
-			{TokenType::MULT, 2}, {TokenType::DIVISION, 2}, 
-			{TokenType::PLUS, 1}, {TokenType::MINUS, 1}, 
-			{TokenType::X, 0}, {TokenType::NUMERICAL, 0}, 
-			{TokenType::PI, 0}, {TokenType::E, 0}, 
-			{TokenType::WHITESPACE, -1}
-		};
-	private:
-		Token GetToken();
-		Func* MakeFunc(Token t, Func* arg);
-		Func* MakeFunc(Func* f1, Token op, Func* f2);
-		Func* ParseSimpleExpression();
-		Func* ParseBinaryExpression(int order);
+		size_t bad{ std::string_view::npos };
 	};
+
+	/*!
+	\brief Функция парсит функцию из потока, не держа в памяти ни весь текст, ни все токены
+
+	Токены берутся из TokenStream по одному и сразу идут в разбор, поэтому кроме 
+	самой функции в хранилище память нужна только на стеки разбора (их глубина - 
+	глубина вложенности) и на один блок чтения. Недопустимый символ обнаруживается, 
+	когда до него доходит разбор, поэтому ошибка разбора раньше него сообщается первой
+	\param[in] is поток
+	\return ParseResult то же, что Parser::TryParse(); offset - от начала потока
+	*/
+	ParseResult TryParse(std::istream& is);
+	/*!
+	\brief TryParse() с исключением при ошибке
+	\throw std::runtime_error - те же ошибки, что у Parser::Parse()
+	\return Func* функция из FuncStore::Current()
+	*/
+	Func* Parse(std::istream& is);
+	/*!
+	\brief Функция парсит функцию из файла, отображенного в память
+
+	Текст не копируется: страницы файла читает система по мере разбора
+	\param[in] path путь к файлу
+	\throw std::runtime_error - если файл не удалось прочитать, и ошибки Parser::Parse()
+	\return Func* функция из FuncStore::Current()
+	*/
+	Func* ParseFile(const std::string& path);
 }
 
 #endif !PARSER_PARSER_H_20211229
\ No newline at end of file
@@ -20,6 +20,9 @@ MainWindow::~MainWindow()
 
 void MainWindow::on_calcderb_clicked()
 {
+    // все функции одного нажатия живут в хранилище и освобождаются вместе с ним
+    FuncStore store;
+    FuncStore::Scope scope(store);
     try {
         std::string text(ui->formtext->toPlainText().toStdString());
         simpleparser::Parser pr(text);
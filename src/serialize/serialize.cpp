@@ -0,0 +1,172 @@
+﻿#include <serialize/serialize.h>
+
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace serialize {
+	namespace {
+		constexpr char kMagic[4] = { 'D', 'R', 'V', 'G' };
+
+		std::uint32_t Bits(float value) {
+			std::uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			return bits;
+		}
+
+		template <class T>
+		void Put(std::ostream& os, const std::vector<T>& items) {
+			if (!items.empty()) os.write(reinterpret_cast<const char*>(items.data()), static_cast<std::streamsize>(items.size() * sizeof(T)));
+		}
+
+		[[noreturn]] void Fail(const char* what) {
+			throw std::runtime_error(std::string("serialize: ") + what);
+		}
+	}
+
+	void Write(const std::vector<Func*>& roots, std::ostream& os) {
+		std::vector<Node> nodes;
+		std::vector<float> constants;
+		std::vector<std::uint32_t> indices;
+		std::string names;
+		std::unordered_map<const Func*, std::uint32_t> index;
+		std::unordered_map<std::uint32_t, std::uint32_t> constant;
+		for (Func* root : roots) {
+			std::vector<std::pair<Func*, bool>> stack{ { root, false } };
+			while (!stack.empty()) {
+				auto [f, expanded] = stack.back();
+				if (index.count(f)) {
+					stack.pop_back();
+					continue;
+				}
+				if (!expanded) {
+					stack.back().second = true;
+					for (int i = f->Arity() - 1; i >= 0; --i)
+						if (!index.count(f->Arg(i))) stack.push_back({ f->Arg(i), false });
+					continue;
+				}
+				stack.pop_back();
+				Node node{ static_cast<std::uint32_t>(f->type), 0, 0 };
+				if (f->type == FuncType::NUM) {
+					float value = static_cast<const Num*>(f)->Value();
+					auto [slot, fresh] = constant.emplace(Bits(value), static_cast<std::uint32_t>(constants.size()));
+					if (fresh) constants.push_back(value);
+					node.a = slot->second;
+				}
+				else if (f->type == FuncType::VAR) {
+					const std::string& name = static_cast<const Var*>(f)->Name();
+					node.a = static_cast<std::uint32_t>(names.size());
+					node.b = static_cast<std::uint32_t>(name.size());
+					names += name;
+				}
+				else {
+					if (f->Arity() > 0) node.a = index.at(f->Arg(0));
+					if (f->Arity() > 1) node.b = index.at(f->Arg(1));
+				}
+				index.emplace(f, static_cast<std::uint32_t>(nodes.size()));
+				nodes.push_back(node);
+			}
+			indices.push_back(index.at(root));
+		}
+		Header header{ { kMagic[0], kMagic[1], kMagic[2], kMagic[3] }, kVersion,
+			static_cast<std::uint32_t>(nodes.size()), static_cast<std::uint32_t>(constants.size()),
+			static_cast<std::uint32_t>(indices.size()), static_cast<std::uint32_t>(names.size()) };
+		os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		Put(os, nodes);
+		Put(os, constants);
+		Put(os, indices);
+		os.write(names.data(), static_cast<std::streamsize>(names.size()));
+	}
+
+	Graph::Graph(const void* data, size_t size) {
+		const char* bytes = static_cast<const char*>(data);
+		if (size < sizeof(Header)) Fail("file is too short");
+		header = reinterpret_cast<const Header*>(bytes);
+		if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0) Fail("not a function graph");
+		if (header->version != kVersion) Fail("unsupported version");
+		size_t expected = sizeof(Header) + size_t(header->nodes) * sizeof(Node) + size_t(header->constants) * sizeof(float) +
+			size_t(header->roots) * sizeof(std::uint32_t) + header->names;
+		if (size != expected) Fail("size does not match the header");
+		nodes = reinterpret_cast<const Node*>(bytes + sizeof(Header));
+		constants = reinterpret_cast<const float*>(nodes + header->nodes);
+		roots = reinterpret_cast<const std::uint32_t*>(constants + header->constants);
+		names = reinterpret_cast<const char*>(roots + header->roots);
+		// аргументы записаны раньше функции, поэтому Load() находит их уже построенными
+		for (std::uint32_t i = 0; i < header->nodes; ++i) {
+			const Node& node = nodes[i];
+			if (node.type > static_cast<std::uint32_t>(FuncType::VAR)) Fail("unknown function type");
+			FuncType type = static_cast<FuncType>(node.type);
+			bool valid = true;
+			switch (type) {
+			case FuncType::NUM: valid = node.a < header->constants; break;
+			case FuncType::VAR: valid = node.b > 0 && node.a <= header->names && node.b <= header->names - node.a; break;
+			case FuncType::E:
+			case FuncType::PI:
+			case FuncType::X: break;
+			case FuncType::SUM:
+			case FuncType::SUB:
+			case FuncType::MULT:
+			case FuncType::DIVISION:
+			case FuncType::POW: valid = node.a < i && node.b < i; break;
+			default: valid = node.a < i; break;
+			}
+			if (!valid) Fail("bad node");
+		}
+		for (std::uint32_t i = 0; i < header->roots; ++i)
+			if (roots[i] >= header->nodes) Fail("bad root");
+	}
+
+	std::vector<Func*> Graph::Load() const {
+		std::vector<Func*> made(header->nodes);
+		FuncStore& store = FuncStore::Current();
+		store.Reserve(store.Size() + header->nodes);
+		for (std::uint32_t i = 0; i < header->nodes; ++i) {
+			const Node& node = nodes[i];
+			Func* a = nullptr;
+			Func* b = nullptr;
+			switch (static_cast<FuncType>(node.type)) {
+			case FuncType::NUM:
+			case FuncType::VAR:
+			case FuncType::E:
+			case FuncType::PI:
+			case FuncType::X: break;
+			case FuncType::SUM:
+			case FuncType::SUB:
+			case FuncType::MULT:
+			case FuncType::DIVISION:
+			case FuncType::POW: a = made[node.a]; b = made[node.b]; break;
+			default: a = made[node.a]; break;
+			}
+			Func*& f = made[i];
+			switch (static_cast<FuncType>(node.type)) {
+			case FuncType::NUM: f = Make<Num>(constants[node.a]); break;
+			case FuncType::E: f = Make<E>(); break;
+			case FuncType::PI: f = Make<PI>(); break;
+			case FuncType::X: f = Make<X>(); break;
+			case FuncType::VAR: f = Make<Var>(std::string_view(names + node.a, node.b)); break;
+			case FuncType::SUM: f = Make<Sum>(a, b); break;
+			case FuncType::SUB: f = Make<Sub>(a, b); break;
+			case FuncType::MULT: f = Make<Mult>(a, b); break;
+			case FuncType::DIVISION: f = Make<Division>(a, b); break;
+			case FuncType::POW: f = Make<Pow>(a, b); break;
+			case FuncType::SIN: f = Make<Sin>(a); break;
+			case FuncType::COS: f = Make<Cos>(a); break;
+			case FuncType::TG: f = Make<Tg>(a); break;
+			case FuncType::CTG: f = Make<Ctg>(a); break;
+			case FuncType::LN: f = Make<Ln>(a); break;
+			case FuncType::LG: f = Make<Lg>(a); break;
+			case FuncType::SQRT: f = Make<Sqrt>(a); break;
+			}
+		}
+		std::vector<Func*> result;
+		for (std::uint32_t i = 0; i < header->roots; ++i) result.push_back(made[roots[i]]);
+		return result;
+	}
+
+	std::vector<Func*> Load(const std::string& path) {
+		MappedFile file(path);
+		return Graph(file.Data(), file.Size()).Load();
+	}
+}
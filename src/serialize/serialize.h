@@ -0,0 +1,123 @@
+﻿#ifndef SERIALIZE_SERIALIZE_H_20261018
+#define SERIALIZE_SERIALIZE_H_20261018
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include <functions/functions.h>
+#include <mapping/mapping.h>
+
+/*!
+\brief Пространство имен, содержащее двоичный формат графов функций
+
+Файл версии 1 (все числа little-endian):
+\code
+Header    заголовок: "DRVG", версия, количества узлов, констант, корней и байт имен
+Node[]    узлы в обратном порядке обхода: аргументы раньше функции
+float[]   числа Num, каждое значение один раз
+uint32[]  номера узлов-корней
+char[]    имена переменных Var подряд
+\endcode
+Узел хранит FuncType и два поля: номера аргументов для операций, номер числа для NUM,
+смещение и длину имени для VAR. Общая подфункция хранится один раз, поэтому размер
+файла линеен по числу различных подфункций, а не по длине repr().
+*/
+namespace serialize {
+
+	/// Версия формата, которую пишет Write()
+	constexpr std::uint32_t kVersion = 1;
+
+	/// Заголовок файла
+	struct Header {
+		/// Сигнатура "DRVG"
+		char magic[4];
+		/// Версия формата
+		std::uint32_t version;
+		/// Количество узлов
+		std::uint32_t nodes;
+		/// Количество чисел
+		std::uint32_t constants;
+		/// Количество корней
+		std::uint32_t roots;
+		/// Длина имен в байтах
+		std::uint32_t names;
+	};
+
+	/// Узел графа
+	struct Node {
+		/// FuncType
+		std::uint32_t type;
+		/// Первый аргумент, номер числа или смещение имени
+		std::uint32_t a;
+		/// Второй аргумент или длина имени
+		std::uint32_t b;
+	};
+
+	/*!
+	\brief Функция записывает функции и все их подфункции за один обход
+
+	Пример
+	\code
+	std::ofstream file("library.drvg", std::ios::binary);
+	serialize::Write({ f, f->Der(), f->Der()->Der() }, file);
+	\endcode
+	\param[in] roots функции
+	\param[out] os двоичный поток
+	*/
+	void Write(const std::vector<Func*>& roots, std::ostream& os);
+
+	/*!
+	\brief Класс, читающий граф прямо из памяти без копирования
+
+	Конструктор проверяет заголовок, размеры разделов и номера в узлах, после
+	чего узлы читаются из переданной памяти как есть
+	*/
+	class Graph {
+	public:
+		/*!
+		\brief Конструктор графа над памятью
+		\param[in] data начало файла, выровненное на 4 байта; память должна жить дольше графа
+		\param[in] size размер в байтах
+		\throw std::runtime_error если данные не файл формата или версия не поддерживается
+		*/
+		Graph(const void* data, size_t size);
+		/// Количество узлов
+		size_t Nodes() const noexcept { return header->nodes; }
+		/// Узел i
+		const Node& At(size_t i) const noexcept { return nodes[i]; }
+		/// Количество корней
+		size_t Roots() const noexcept { return header->roots; }
+		/// Номер узла корня i
+		std::uint32_t Root(size_t i) const noexcept { return roots[i]; }
+		/*!
+		\brief Метод строит функции графа в FuncStore::Current()
+
+		Функции создаются одним проходом по таблице узлов без разбора текста; уже
+		имеющиеся в хранилище структурно равные функции переиспользуются
+		\return std::vector<Func*> корни в порядке записи
+		*/
+		std::vector<Func*> Load() const;
+	private:
+		const Header* header;
+		const Node* nodes;
+		const float* constants;
+		const std::uint32_t* roots;
+		const char* names;
+	};
+
+	/// Файл, отображенный в память только для чтения (см. mapping::MappedFile)
+	using MappedFile = mapping::MappedFile;
+
+	/*!
+	\brief Функция загружает функции из файла, отображенного в память
+	\param[in] path путь к файлу
+	\return std::vector<Func*> корни в порядке записи, из FuncStore::Current()
+	\throw std::runtime_error если файл не удалось прочитать
+	*/
+	std::vector<Func*> Load(const std::string& path);
+}
+
+#endif // !SERIALIZE_SERIALIZE_H_20261018
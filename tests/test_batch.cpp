@@ -0,0 +1,53 @@
+﻿#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <batch/batch.h>
+#include <batch/parallel.h>
+#include <parser/parser.h>
+
+int main() {
+	std::vector<batch::Result> results = batch::Differentiate({ "sin(x) ^ 2", "x * y + y ^ 2", "(x", "ln(x) / x" });
+	for (const batch::Result& r : results) {
+		if (r) std::cout << r.derivative << '\n';
+		else std::cout << "error: " << r.error << " at " << r.offset + 1 << '\n';
+	}
+	batch::Options options;
+	options.variable = "y";
+	std::cout << batch::Differentiate({ "x * y + y ^ 2" }, options)[0].derivative << "\n\n";
+	if (!results[0] || results[2] || results[2].offset != 2) return 1;
+
+	// одинаковая работа при разном числе потоков; результаты не зависят от числа потоков
+	const char* forms[] = { "sin(x) ^ 3 * cos(x)", "x * e ^ (0.5 - x) / ln(x)", "tg(x ^ 2) + sqrt(x + 1)", "lg(x) ^ x" };
+	std::vector<std::string> inputs;
+	for (int i = 0; i < 4000; ++i) inputs.push_back(std::string(forms[i % 4]) + " + " + std::to_string(i));
+	options = {};
+	options.order = 3;
+	std::vector<batch::Result> reference = batch::Differentiate(inputs, options, batch::ThreadPool::Default());
+	// время только для сведения: на одном ядре потоки не ускоряют; проверяются результаты
+	bool all = true;
+	for (size_t threads : { 1, 2, 4, 8 }) {
+		batch::ThreadPool pool(threads);
+		auto start = std::chrono::steady_clock::now();
+		std::vector<batch::Result> out = batch::Differentiate(inputs, options, pool);
+		std::chrono::duration<double, std::milli> ms = std::chrono::steady_clock::now() - start;
+		bool same = true;
+		for (size_t i = 0; i < out.size(); ++i) same = same && out[i].derivative == reference[i].derivative;
+		std::cout << threads << " threads: " << ms.count() << " ms, " << (same ? "same" : "DIFFERENT") << '\n';
+		all = all && same;
+	}
+
+	// одна большая функция: значения на потоках пула те же, что в одном потоке
+	std::string huge;
+	for (int i = 0; i < 3000; ++i) huge += std::string(i ? " + " : "") + forms[i % 4] + " * sin(" + std::to_string(i + 1) + " * x)";
+	Func* d = Simplify(Simplify(simpleparser::Parser(huge).Parse())->Der());
+	bytecode::Program program(d);
+	std::vector<double> xs(20000), a(xs.size()), b(xs.size());
+	for (size_t i = 0; i < xs.size(); ++i) xs[i] = 1.5 + 1e-4 * static_cast<double>(i);
+	program.EvalBatch(xs.data(), a.data(), xs.size());
+	batch::ThreadPool pool(4);
+	batch::EvalBatch(program, xs.data(), b.data(), xs.size(), pool);
+	std::cout << '\n' << program.Size() << " instructions, " << (a == b ? "same" : "DIFFERENT") << " values, f'(1.5) = " << b[0] << '\n';
+	return all && a == b ? 0 : 1;
+}
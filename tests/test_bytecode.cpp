@@ -0,0 +1,75 @@
+﻿#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+#include <bytecode/bytecode.cpp>
+#include <parser/parser.h>
+
+int main() {
+	simpleparser::Parser parser("x*x*(x^10)+15*sin(x)");
+	Func* f(parser.Parse());
+	Func* d(f->Der());
+	bytecode::Program program({ f, d });
+	std::cout << program.Size() << ' ' << program.Registers() << '\n';
+	double out[2];
+	program.Eval(0.5, out);
+	std::cout << out[0] << ' ' << f->Eval(0.5) << '\n';
+	std::cout << out[1] << ' ' << d->Eval(0.5) << '\n';
+	simpleparser::Parser p("cos(x)^x");
+	bytecode::Program g(p.Parse()->Der());
+	std::cout << g.Eval(0.5) << '\n';
+	// векторные ядра сверяются со скалярными, в том числе на точках, которые 
+	// пересчитываются стандартной библиотекой: нули, субнормальные числа, 
+	// отрицательные основания, |x| > 1e8, переполнение e ^ x, inf и nan
+	const double inf = std::numeric_limits<double>::infinity();
+	std::vector<double> xs{ 0.0, -0.0, 5e-324, -5e-324, 1e-310, -1e-310, DBL_MIN, -DBL_MIN, 1e-300,
+		0.5, 1.0, -1.0, -2.5, 3.0, 700.0, 709.7, 710.0, -745.0, -746.0, 1e8, -1e8, 1.5e8, -3e9,
+		1e300, -1e300, DBL_MAX, -DBL_MAX, inf, -inf, std::nan("") };
+	for (int i = -400; i <= 400; ++i) xs.push_back(i * 0.37);
+	for (int i = 0; i < 200; ++i) xs.push_back(std::ldexp(1.0 + i / 200.0, i - 100));
+	std::vector<bytecode::Program> programs{ program };
+	for (const char* text : { "sin(x)", "cos(x)", "tg(x)", "ctg(x)", "ln(x)", "lg(x)", "sqrt(x)", "x / x",
+		"e ^ x", "2 ^ x", "x ^ 3", "x ^ 0.5", "x ^ (0 - 3)", "x ^ x", "(0 - 2.5) ^ x" })
+		programs.emplace_back(simpleparser::Parser(text).Parse());
+	double worst = 0.0;
+	for (const bytecode::Program& batch : programs) {
+		size_t m = batch.Outputs() * xs.size();
+		std::vector<double> expected(m), actual(m);
+		batch.EvalBatch(xs.data(), expected.data(), xs.size(), bytecode::Isa::SCALAR);
+		for (bytecode::Isa isa : { bytecode::Isa::AVX2, bytecode::Isa::AVX512 }) {
+			batch.EvalBatch(xs.data(), actual.data(), xs.size(), isa);
+			for (size_t i = 0; i < m; ++i) {
+				double a = actual[i], b = expected[i];
+				if (std::isnan(a) || std::isnan(b) || std::isinf(a) || std::isinf(b)) {
+					if (std::isnan(a) != std::isnan(b) || (!std::isnan(a) && a != b)) return 1;
+					continue;
+				}
+				worst = std::max(worst, std::abs(a - b) / std::max(std::abs(b), DBL_MIN));
+			}
+		}
+	}
+	// x ^ y теряет точность пропорционально |y ln x|: около 36 ulp у e ^ 700
+	std::cout << (worst < 4e-14) << "\n\n";
+	if (worst >= 4e-14) return 1;
+	simpleparser::Parser multi("x * y + sin(x * z) / sqrt(y)");
+	Func* h(multi.Parse());
+	std::vector<Func*> vars(Variables(h));
+	std::vector<Func*> roots(Gradient(h, vars));
+	roots.insert(roots.begin(), h);
+	bytecode::Program gradient(roots, vars);
+	double point[] = { 0.5, 2.0, 3.0 }, values3[4];
+	gradient.Eval(point, values3);
+	std::cout << gradient.Inputs() << ' ' << gradient.Size() << '\n';
+	std::cout << values3[0] << ' ' << values3[1] << ' ' << values3[2] << ' ' << values3[3] << "\n\n";
+	// функции из хранилища по умолчанию, программы собираются в другом: сборка 
+	// только читает функцию и не создает в ней узлов
+	Func* square(simpleparser::Parser("x ^ 2").Parse());
+	Func* derivative(square->Der());
+	FuncStore store;
+	FuncStore::Scope scope(store);
+	double outside = bytecode::Program(square).Eval(3.0), der = bytecode::Program(derivative).Eval(3.0);
+	std::cout << outside << ' ' << der << '\n';
+	if (outside != 9.0 || der != 6.0) return 1;
+}
@@ -0,0 +1,72 @@
+﻿#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+#include <cache/cache.h>
+#include <parser/parser.h>
+
+void Print(const cache::Statistics& stats) {
+	std::cout << stats.hits << " hits, " << stats.disk_hits << " disk hits, " << stats.misses << " misses, "
+		<< stats.evictions << " evictions, " << stats.entries << " entries\n";
+}
+
+int main() {
+	const char* directory = "test_cache";
+	std::filesystem::remove_all(directory);
+	cache::Options options;
+	options.order = 2;
+	options.simplify = true;
+	{
+		cache::DerivativeCache derivatives(1 << 20, directory);
+		Func* f = simpleparser::Parser("sin(x) ^ 2 * ln(x)").Parse();
+		std::cout << *derivatives.Derivative(f, options) << '\n';
+		std::cout << *derivatives.Derivative(f, options) << '\n';
+		// ключ зависит от строения функции, а не от ее записи или хранилища
+		FuncStore store;
+		FuncStore::Scope scope(store);
+		Func* g = simpleparser::Parser("(sin(x)^2)*(ln(x))").Parse();
+		std::cout << (cache::MakeKey(f, options) == cache::MakeKey(g, options)) << ' ';
+		std::cout << (cache::MakeKey(f, options) == cache::MakeKey(g, {})) << '\n';
+		if (!(cache::MakeKey(f, options) == cache::MakeKey(g, options)) || cache::MakeKey(f, options) == cache::MakeKey(g, {})) return 1;
+		derivatives.Derivative(g, options);
+		Print(derivatives.Stats());
+	}
+	{
+		// новый кэш над тем же каталогом: запись читается с диска
+		cache::DerivativeCache derivatives(1 << 20, directory);
+		Func* f = simpleparser::Parser("sin(x) ^ 2 * ln(x)").Parse();
+		std::cout << *derivatives.Derivative(f, options) << '\n';
+		Print(derivatives.Stats());
+		if (derivatives.Stats().disk_hits != 1 || derivatives.Stats().misses != 0) return 1;
+	}
+	{
+		// бюджет на несколько записей: давние вытесняются
+		cache::DerivativeCache derivatives(2048);
+		for (int i = 0; i < 50; ++i) derivatives.Derivative(simpleparser::Parser("x ^ " + std::to_string(i) + " * tg(x)").Parse());
+		for (int i = 45; i < 50; ++i) derivatives.Derivative(simpleparser::Parser("x ^ " + std::to_string(i) + " * tg(x)").Parse());
+		Print(derivatives.Stats());
+		std::cout << derivatives.Stats().bytes << '\n';
+		if (derivatives.Stats().evictions == 0 || derivatives.Stats().bytes > 2048) return 1;
+	}
+	{
+		// функция из другого хранилища отвергается и не оставляет записи в кэше
+		cache::DerivativeCache derivatives(1 << 20);
+		Func* f = simpleparser::Parser("x ^ 2").Parse();
+		{
+			FuncStore store;
+			FuncStore::Scope scope(store);
+			try {
+				derivatives.Derivative(f);
+				return 1;
+			}
+			catch (const std::runtime_error& e) {
+				std::cout << e.what() << '\n';
+			}
+		}
+		std::string der = *derivatives.Derivative(f);
+		std::cout << der << '\n';
+		Print(derivatives.Stats());
+		if (der != f->Der()->repr() || derivatives.Stats().misses != 1) return 1;
+	}
+	std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,25 @@
+﻿#include <iostream>
+
+#include <codegen/codegen.h>
+#include <parser/parser.h>
+
+int main() {
+	simpleparser::Parser parser("sin(x) ^ 3 / cos(x)");
+	Func* f(parser.Parse());
+	Func* d(f->Der());
+	std::cout << d->repr() << "\n\n";
+	std::cout << codegen::Generate(d) << '\n';
+	codegen::Write({ f, d }, { "f", "df" }, std::cout, codegen::Language::CPP);
+	std::cout << '\n';
+	// без упрощения длина repr() растет экспоненциально с порядком производной
+	Func* g(simpleparser::Parser("x * e ^ (0.5 - x) / ln(x)").Parse());
+	for (int n = 1; n <= 6; ++n) {
+		g = g->Der();
+		std::cout << n << ' ' << g->repr().size() << ' ' << codegen::Generate(g).size() << '\n';
+	}
+	// временные переменные и результат не совпадают с переменными функции
+	Func* h(simpleparser::Parser("sin(t1*x)^2 + sin(t1*x)*cos(t1*x) + cos(t1*x)^2 + result").Parse());
+	std::string text(codegen::Generate(h, codegen::Language::CPP));
+	std::cout << '\n' << text;
+	if (text.find("double t1 =") != std::string::npos || text.find("double result =") != std::string::npos) return 1;
+}
@@ -1,13 +1,56 @@
-#include <iostream>
+﻿#include <iostream>
+#include <stdexcept>
 
 #include <functions/functions.cpp>
+#include <functions/stats.h>
 
 int main() {
-	Func* num(new Num(4));
-	Func* cos(new Cos(num));
+	Func* num(Make<Num>(4));
+	Func* cos(Make<Cos>(num));
 	std::cout << cos->repr() << '\n';
-	Func* exp(new Pow(new E(), new X()));
-	Func* sum(new Sum(cos, exp));
+	Func* exp(Make<Pow>(Make<E>(), Make<X>()));
+	Func* sum(Make<Sum>(cos, exp));
 	std::cout << sum->repr() << '\n';
+	std::cout << *sum->Der() << '\n';
 	std::cout << sum->Der()->repr() << '\n';
+	std::cout << sum->Eval(0.5) << ' ' << sum->Der()->Eval(0.5) << '\n';
+	Dual dual(sum->Eval(Dual::Variable(0.5)));
+	std::cout << dual.value << ' ' << dual.der << '\n';
+	Jet jet(sum->Eval(Jet::Variable(0.5, 3)));
+	std::cout << jet.Derivative(2) << ' ' << sum->Der()->Der()->Eval(0.5) << ' ' << jet.Derivative(3) << '\n';
+	FuncStore store;
+	FuncStore::Scope scope(store);
+	// sum из другого хранилища: производная не строится и не запоминается
+	bool rejected = false;
+	try {
+		sum->Der();
+	}
+	catch (const std::runtime_error&) {
+		rejected = true;
+	}
+	bool same = rejected && Make<Var>("y")->Der(Make<Var>("y"))->repr() == "1";
+	std::cout << same << '\n';
+	if (!same) return 1;
+	Func* a(Make<Pow>(Make<Sin>(Make<X>()), Make<Num>(2)));
+	Func* b(Make<Pow>(Make<Sin>(Make<X>()), Make<Num>(2)));
+	std::cout << (a == b) << ' ' << store.Size() << '\n';
+	std::cout << a->Der()->Der()->repr() << ' ' << store.Size() << '\n';
+	// (x^0.5)^2 не сворачивается в x: при x < 0 это NaN
+	Func* root(Make<Pow>(Make<Pow>(Make<X>(), Make<Num>(0.5f)), Make<Num>(2)));
+	std::cout << Simplify(root)->repr() << ' ' << Simplify(Make<Pow>(Make<Pow>(Make<X>(), Make<Num>(2)), Make<Num>(3)))->repr() << '\n';
+	if (Simplify(root) == Make<X>()) return 1;
+	// запись 10-й производной экспоненциально длинна, а различных функций в ней немного
+	Func* power(Make<Mult>(Make<Pow>(Make<Sin>(Make<X>()), Make<X>()), Make<Ln>(Make<X>())));
+	Func* tenth(power);
+	for (int i = 0; i < 10; ++i) tenth = tenth->Der();
+	double expected = power->Eval(Jet::Variable(1.3, 10)).Derivative(10);
+	Dual eleventh = tenth->Eval(Dual::Variable(1.3));
+	std::cout << tenth->Eval(1.3) << ' ' << expected << ' ' << eleventh.der << '\n';
+	if (std::abs(tenth->Eval(1.3) - expected) > 1e-9 * std::abs(expected)) return 1;
+	if (std::abs(eleventh.der - tenth->Der()->Eval(1.3)) > 1e-9 * std::abs(eleventh.der)) return 1;
+	// счетчики заполняются только в сборке с DERIVATIVE_STATS
+	stats::Reset();
+	Func* c(Make<Mult>(a, Make<Cos>(Make<X>())));
+	std::cout << c->Der()->Der()->Der()->repr().size() << '\n';
+	stats::Dump(std::cout);
 }
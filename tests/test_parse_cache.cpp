@@ -0,0 +1,51 @@
+﻿#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <parse_cache/parse_cache.h>
+
+void Print(const simpleparser::ParseCache& parses) {
+	simpleparser::ParseCache::Statistics stats = parses.Stats();
+	std::cout << stats.hits << " hits, " << stats.misses << " misses, " << parses.Size() << " entries\n";
+}
+
+int main() {
+	simpleparser::ParseCache parses(2);
+	std::cout << simpleparser::ParseCache::Normalize("  sin( x ) *\tx1 + 2 .5") << '\n';
+	Func* f = parses.Parse("sin(x) * x");
+	Func* g = parses.Parse(" sin( x )*x ");
+	std::cout << f->repr() << ' ' << (f == g) << '\n';
+	Print(parses);
+	if (f != g || parses.Stats().hits != 1) return 1;
+	// ошибки не запоминаются, а "x y" не попадает в запись "xy"
+	simpleparser::ParseResult bad = parses.TryParse("x + sin(2 * x");
+	std::cout << bad.error << " at " << bad.offset << '\n';
+	std::cout << parses.TryParse("x y").error << " | " << parses.Parse("xy")->repr() << '\n';
+	if (bad || parses.TryParse("x y")) return 1;
+	Print(parses);
+	// запись из кэша собирается в хранилище вызывающего потока
+	{
+		FuncStore store;
+		FuncStore::Scope scope(store);
+		Func* h = parses.Parse("xy");
+		std::cout << h->repr() << ' ' << (h->Der(Make<Var>("xy")) == Make<Num>(1)) << '\n';
+		if (h->Der(Make<Var>("xy")) != Make<Num>(1)) return 1;
+	}
+	parses.Parse("cos(x)");
+	parses.Parse("sin(x)*x");
+	Print(parses);
+	std::vector<std::thread> threads;
+	std::vector<std::string> results(4);
+	for (size_t i = 0; i < results.size(); ++i)
+		threads.emplace_back([&parses, &results, i] {
+			for (int j = 0; j < 1000; ++j) results[i] = parses.Parse(j % 2 ? "cos(x)" : "ln(x) / x")->Der()->repr();
+		});
+	for (std::thread& thread : threads) thread.join();
+	for (const std::string& result : results) std::cout << result << '\n';
+	Print(parses);
+	for (const std::string& result : results)
+		if (result != results[0]) return 1;
+	parses.Clear();
+	Print(parses);
+	return parses.Size() == 0 ? 0 : 1;
+}
@@ -1,12 +1,14 @@
-#include <iostream>
+﻿#include <iostream>
+#include <sstream>
 
 #include <parser/parser.cpp>
 
 int main() {
 	simpleparser::Tokenizer tz;
-	auto x = tz.Tokenize("(x + 22) * cos(x / 2)");
+	std::string input("(x + 22) * cos(x / 2)");
+	auto x = tz.Tokenize(input);
 	for (auto s : x) {
-		std::cout << s.text << " | ";
+		std::cout << s.Text(input) << " | ";
 	}
 	std::cout << "\n\n";
 	simpleparser::Parser parser("x*x*(x^10)+15*sin(x)");
@@ -16,4 +18,64 @@ int main() {
 	simpleparser::Parser p("cos(x)^x");
 	Func* g(p.Parse());
 	std::cout << g->Der()->repr() << "\n\n";
+	std::cout << Simplify(f->Der())->repr() << '\n';
+	std::cout << Simplify(g->Der())->repr() << '\n';
+	std::cout << Simplify(g->Der()->Der())->repr() << "\n\n";
+	std::cout << Derivative(g, 3)->repr() << '\n';
+	std::cout << Derivative(f, 5)->repr() << "\n\n";
+	simpleparser::Parser bad("x + sin(2 * x");
+	simpleparser::ParseResult result = bad.TryParse();
+	std::cout << result.error << " at " << result.offset << '\n';
+	std::string deep;
+	for (int i = 0; i < 100000; ++i) deep += "sin(";
+	deep += "x";
+	for (int i = 0; i < 100000; ++i) deep += ")";
+	simpleparser::Parser nested(deep);
+	std::cout << (nested.TryParse().func != nullptr) << "\n\n";
+	std::string names("sinh * x1 + sin(speed_2 * x)");
+	for (auto s : tz.Tokenize(names)) std::cout << s.Text(names) << " | ";
+	std::cout << '\n';
+	simpleparser::Parser multi("x * y + sin(x * z) / sqrt(y)");
+	Func* h(multi.Parse());
+	std::vector<Func*> vars(Variables(h));
+	std::vector<Func*> grad(Gradient(h, vars));
+	for (size_t i = 0; i < vars.size(); ++i)
+		std::cout << vars[i]->repr() << ": " << h->Der(vars[i])->repr() << " | " << Simplify(grad[i])->repr() << '\n';
+	SparseMatrix hessian(Hessian(h, vars));
+	for (const SparseMatrix::Entry& e : hessian.entries)
+		std::cout << e.row << ' ' << e.col << ": " << Simplify(e.f)->repr() << '\n';
+	simpleparser::Parser first("x * y"), second("sin(z) + x");
+	SparseMatrix jacobian(Jacobian({ first.Parse(), second.Parse() }, vars));
+	std::cout << jacobian.entries.size() << ' ' << (jacobian.At(0, 2) == nullptr) << ' ' << jacobian.At(1, 2)->repr() << '\n';
+	std::istringstream stream("x*x*(x^10)+15*sin(x)");
+	Func* streamed = simpleparser::Parse(stream);
+	std::cout << (streamed == f) << ' ';
+	std::istringstream broken("x + sin(2 * x");
+	simpleparser::ParseResult from_stream = simpleparser::TryParse(broken);
+	std::cout << from_stream.error << " at " << from_stream.offset << '\n';
+	// поток дает те же функции и ошибки, что и строка
+	if (streamed != f || from_stream.error != result.error || from_stream.offset != result.offset) return 1;
+	// имя длиннее блока чтения склеивается из нескольких блоков
+	std::string longer(100000, 'a');
+	std::istringstream names_stream("sin(" + longer + ") + " + longer);
+	std::cout << simpleparser::Parse(names_stream)->repr().size() << ' ';
+	std::istringstream bad_symbol("x + 2 # 3");
+	std::cout << simpleparser::TryParse(bad_symbol).offset << '\n';
+	std::istringstream bad_again("x + 2 # 3");
+	if (simpleparser::TryParse(bad_again).offset != 6) return 1;
+	// слитная запись ключевых слов: функция с аргументом разбивается, константы отвергаются
+	const char* joined[][2] = { { "sinx", "sin(x)" }, { "cosx^2", "cos(x) ^ 2" }, { "lnx + sqrtx", "ln(x) + sqrt(x)" },
+		{ "sincosx", "sin(cos(x))" }, { "ln2", "ln(2)" }, { "sinh", "sinh" } };
+	for (auto& [text, same] : joined) {
+		Func* split = simpleparser::Parser(text).Parse();
+		std::cout << text << ": " << split->repr() << " | ";
+		if (split != simpleparser::Parser(same).Parse()) return 1;
+	}
+	std::cout << '\n';
+	for (const char* text : { "pix", "ex", "2 * xx" }) {
+		simpleparser::ParseResult rejected = simpleparser::Parser(text).TryParse();
+		std::cout << text << ": " << rejected.error << " at " << rejected.offset << " | ";
+		if (rejected) return 1;
+	}
+	std::cout << '\n';
 }
\ No newline at end of file
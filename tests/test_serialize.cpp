@@ -0,0 +1,48 @@
+﻿#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <parser/parser.h>
+#include <serialize/serialize.h>
+
+int main() {
+	Func* f(simpleparser::Parser("sin(x) ^ 3 * ln(y + 0.5) / x").Parse());
+	std::vector<Func*> roots{ f };
+	for (int n = 1; n <= 6; ++n) roots.push_back(roots.back()->Der());
+	std::ostringstream os;
+	serialize::Write(roots, os);
+	std::string bytes = os.str();
+	std::cout << roots.back()->repr().size() << ' ' << bytes.size() << '\n';
+
+	// в том же хранилище загруженные функции совпадают с исходными по указателю
+	serialize::Graph graph(bytes.data(), bytes.size());
+	std::vector<Func*> same = graph.Load();
+	std::cout << graph.Nodes() << ' ' << (same == roots) << '\n';
+	if (same != roots) return 1;
+
+	const char* path = "test_serialize.drvg";
+	{
+		std::ofstream file(path, std::ios::binary);
+		serialize::Write(roots, file);
+	}
+	{
+		FuncStore store;
+		FuncStore::Scope scope(store);
+		std::vector<Func*> loaded = serialize::Load(path);
+		std::cout << loaded.size() << ' ' << (loaded[3]->repr() == roots[3]->repr()) << ' ' << store.Size() << '\n';
+		std::cout << loaded[1]->repr() << '\n';
+		if (loaded.size() != roots.size() || loaded[3]->repr() != roots[3]->repr()) return 1;
+	}
+	std::remove(path);
+
+	bytes[0] = 'X';
+	try {
+		serialize::Graph bad(bytes.data(), bytes.size());
+		return 1;
+	}
+	catch (const std::runtime_error& e) {
+		std::cout << e.what() << '\n';
+	}
+}
@@ -0,0 +1,32 @@
+﻿#include <iostream>
+#include <numeric>
+#include <sstream>
+
+#include <functions/stats.h>
+#include <parser/parser.h>
+
+// Счетчики пусты без DERIVATIVE_STATS и заполняются разбором, Der() и печатью с ним
+int main() {
+	stats::Reset();
+	{
+		FuncStore store;
+		FuncStore::Scope scope(store);
+		Func* f = simpleparser::Parser("sin(x) ^ x * ln(x) + x * x").Parse();
+		std::ostringstream os;
+		os << *f->Der();
+		std::cout << os.str() << '\n';
+	}
+	const stats::Counters& counters = stats::Local();
+	stats::Dump(std::cout);
+	std::cout << '\n';
+	std::uint64_t made = std::accumulate(counters.made.begin(), counters.made.end(), std::uint64_t{ 0 });
+	std::uint64_t created = std::accumulate(counters.created.begin(), counters.created.end(), std::uint64_t{ 0 });
+	std::uint64_t calls = std::accumulate(counters.calls.begin(), counters.calls.end(), std::uint64_t{ 0 });
+	std::uint64_t total = made + created + calls + counters.bytes + counters.derivatives;
+	std::cout << stats::kEnabled << ' ' << made << ' ' << created << ' ' << calls << '\n';
+	if (!stats::kEnabled) return total == 0 ? 0 : 1;
+	if (!made || !created || created > made || !counters.bytes || !counters.derivatives) return 1;
+	for (stats::Phase phase : { stats::Phase::PARSE, stats::Phase::DIFFERENTIATE, stats::Phase::PRINT })
+		if (!counters.calls[static_cast<size_t>(phase)]) return 1;
+	return 0;
+}
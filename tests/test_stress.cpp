@@ -0,0 +1,42 @@
+﻿#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <bytecode/bytecode.h>
+#include <codegen/codegen.h>
+#include <parser/parser.h>
+
+// Цепочки из миллиона функций: рекурсивный обход таких функций переполнил бы стек
+int main() {
+	const int n = 1000000;
+	{
+		FuncStore store;
+		FuncStore::Scope scope(store);
+		std::string text;
+		for (int i = 0; i < n; ++i) text += "sin(";
+		text += "x";
+		text.append(n, ')');
+		simpleparser::Parser parser(text);
+		Func* f = parser.Parse();
+		std::cout << (f->repr() == text) << ' ' << store.Size() << '\n';
+		Func* d = f->Der();
+		std::cout << store.Size() << ' ' << bytecode::Program(d).Size() << '\n';
+		double value = d->Eval(0.5);
+		Dual dual = f->Eval(Dual::Variable(0.5));
+		std::cout << value << ' ' << dual.der << '\n';
+		if (value != bytecode::Program(d).Eval(0.5) || std::abs(dual.der - value) > 1e-12) return 1;
+		std::cout << codegen::Generate(d).size() << ' ' << codegen::Generate(d, codegen::Language::CPP).size() << '\n';
+	}
+	{
+		FuncStore store;
+		FuncStore::Scope scope(store);
+		Func* f = Make<X>();
+		for (int i = 1; i < n; ++i) f = Make<Sum>(f, Make<Mult>(Make<Num>(static_cast<float>(i % 7)), Make<X>()));
+		Func* d = f->Der();
+		std::ostringstream stream;
+		stream << *d;
+		std::cout << f->repr().size() << ' ' << d->repr().size() << ' ' << (stream.str() == d->repr()) << '\n';
+		std::cout << Simplify(f)->repr() << ' ' << Simplify(d)->repr() << '\n';
+		std::cout << bytecode::Program({ f, d }).Registers() << "\n\n";
+	}
+}